@@ -0,0 +1,16 @@
+INIT:	XOR R0 R0 R0
+	ADDI R1 R0 0xA000
+	ADDI R3 R0 0xC000
+	ADDI R4 R0 4
+	ADDI R8 R0 0xC000
+LOOP:	LW R5 0(R1)
+	MULT R6 R5 R4
+	ADD R6 R6 R8
+	SW R1 0(R6)
+	LW R9 0(R3)
+	ADD R10 R10 R9
+	ADDI R1 R1 4
+	ADDI R3 R3 4
+	SUBI R2 R2 1
+	BNEZ R2 LOOP
+	EOP
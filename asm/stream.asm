@@ -0,0 +1,18 @@
+	XOR R0 R0 R0
+	ADDI R1 R0 0xA000
+	ADDI R3 R0 0xC000
+	ADDI R2 R0 2000
+LOOP:	LWS F1 0(R1)
+	LWS F2 4(R1)
+	ADDS F3 F1 F2
+	MULTS F4 F3 F1
+	SWS F4 0(R3)
+	LW R5 0(R3)
+	SW R5 4(R3)
+	DIV R6 R2 R2
+	ADDI R1 R1 4
+	ADDI R3 R3 4
+	SUBI R2 R2 1
+	BNEZ R2 LOOP
+	ADDS F5 F3 F4
+	EOP
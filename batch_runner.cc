@@ -0,0 +1,112 @@
+#include "batch_runner.h"
+
+using namespace std;
+
+batch_runner::batch_runner(unsigned num_threads){
+   numThreads               = num_threads;
+   if( numThreads == 0 )
+      numThreads            = thread::hardware_concurrency();
+   if( numThreads == 0 )
+      numThreads            = 1;
+   queues                   = new batchQueueT[numThreads];
+}
+
+batch_runner::~batch_runner(){
+   delete [] queues;
+}
+
+unsigned batch_runner::add_job(simBuilderT builder, unsigned cycles){
+   ASSERT( builder, "Batch job without a simulator builder" );
+   builders.push_back( builder );
+   runCycles.push_back( cycles );
+   return builders.size() - 1;
+}
+
+void batch_runner::set_on_done(batchDoneT on_done){
+   onDone                   = on_done;
+}
+
+void batch_runner::run(){
+   results.assign( builders.size(), batchResultT() );
+
+   // Deal the jobs round-robin; workers that run dry steal from the others
+   for(unsigned job = 0; job < builders.size(); job++)
+      queues[job % numThreads].jobs.push_back( job );
+
+   vector<thread> workers;
+   for(unsigned id = 1; id < numThreads; id++)
+      workers.push_back( thread( &batch_runner::worker, this, id ) );
+   worker(0);
+   for(unsigned i = 0; i < workers.size(); i++)
+      workers[i].join();
+
+   builders.clear();
+   runCycles.clear();
+}
+
+void batch_runner::worker(unsigned id){
+   unsigned job;
+   while( true ){
+      if( queues[id].popBack( job ) ){
+         runJob( job );
+         continue;
+      }
+
+      // No job is queued while running, so empty queues everywhere mean we are done
+      bool stolen           = false;
+      for(unsigned i = 1; i < numThreads && !stolen; i++)
+         stolen             = queues[(id + i) % numThreads].popFront( job );
+      if( !stolen )
+         return;
+      runJob( job );
+   }
+}
+
+void batch_runner::runJob(unsigned job){
+   sim_ooo *sim             = builders[job]();
+   ASSERT( sim != NULL, "Batch job %u built no simulator", job );
+   sim->run( runCycles[job] );
+
+   results[job].cycles        = sim->get_clock_cycles();
+   results[job].instructions  = sim->get_instructions_executed();
+   results[job].IPC           = sim->get_IPC();
+   if( onDone )
+      onDone( job, results[job], sim );
+   delete sim;
+}
+
+unsigned batch_runner::get_threads(){
+   return numThreads;
+}
+
+unsigned batch_runner::get_jobs(){
+   return results.size();
+}
+
+batchResultT batch_runner::get_result(unsigned job){
+   ASSERT( job < results.size(), "Unknown batch job (=%u)", job );
+   return results[job];
+}
+
+uint64_t batch_runner::get_total_cycles(){
+   uint64_t total           = 0;
+   for(unsigned i = 0; i < results.size(); i++)
+      total                += results[i].cycles;
+   return total;
+}
+
+uint64_t batch_runner::get_total_instructions(){
+   uint64_t total           = 0;
+   for(unsigned i = 0; i < results.size(); i++)
+      total                += results[i].instructions;
+   return total;
+}
+
+float batch_runner::get_mean_IPC(){
+   if( results.empty() )
+      return 0;
+   double total             = 0;
+   for(unsigned i = 0; i < results.size(); i++)
+      total                += results[i].IPC;
+   return total / results.size();
+}
@@ -0,0 +1,108 @@
+#ifndef BATCH_RUNNER_H_
+#define BATCH_RUNNER_H_
+
+#include "sim_ooo.h"
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <deque>
+
+using namespace std;
+
+// Builds a configured simulator with its program and data loaded; the batch runner owns the result
+typedef function<sim_ooo*()> simBuilderT;
+
+struct batchResultT{
+   unsigned       cycles;
+   unsigned       instructions;
+   float          IPC;
+
+   batchResultT(){
+      cycles         = 0;
+      instructions   = 0;
+      IPC            = 0;
+   }
+};
+
+// Called on the worker thread when a job finishes, before its simulator is deleted
+typedef function<void(unsigned job, const batchResultT& result, sim_ooo* sim)> batchDoneT;
+
+// Job queue of one worker: the owner takes from the back, thieves from the front
+struct batchQueueT{
+   mutex          lock;
+   deque<unsigned> jobs;
+
+   bool popBack(unsigned& job){
+      lock_guard<mutex> guard(lock);
+      if( jobs.empty() )
+         return false;
+      job            = jobs.back();
+      jobs.pop_back();
+      return true;
+   }
+
+   bool popFront(unsigned& job){
+      lock_guard<mutex> guard(lock);
+      if( jobs.empty() )
+         return false;
+      job            = jobs.front();
+      jobs.pop_front();
+      return true;
+   }
+};
+
+class batch_runner{
+
+   unsigned              numThreads;
+   vector<simBuilderT>   builders;
+   vector<unsigned>      runCycles;
+   vector<batchResultT>  results;
+   batchDoneT            onDone;
+   batchQueueT           *queues;
+
+   public:
+
+   // instantiates the runner
+   // - num_threads: number of worker threads (0: one per host core)
+   batch_runner(unsigned num_threads=0);
+
+   // de-allocates the runner
+   ~batch_runner();
+
+   // queues a simulation and returns its job number
+   // - builder: instantiates and configures the simulator, called on a worker thread
+   // - cycles: number of cycles to run (0: until EOP)
+   unsigned add_job(simBuilderT builder, unsigned cycles=0);
+
+   // sets a function to call as each job finishes (from the worker threads, concurrently)
+   void set_on_done(batchDoneT on_done);
+
+   // runs all queued jobs to completion on the worker threads, then empties the queue
+   // results stay available until the next call
+   void run();
+
+   //returns the number of worker threads
+   unsigned get_threads();
+
+   //returns the number of jobs of the last run
+   unsigned get_jobs();
+
+   //returns the statistics of a job of the last run
+   batchResultT get_result(unsigned job);
+
+   //returns the clock cycles summed over all jobs of the last run
+   uint64_t get_total_cycles();
+
+   //returns the instructions summed over all jobs of the last run
+   uint64_t get_total_instructions();
+
+   //returns the mean IPC over all jobs of the last run
+   float get_mean_IPC();
+
+   private:
+
+   void worker(unsigned id);
+   void runJob(unsigned job);
+};
+
+#endif /*BATCH_RUNNER_H_*/
@@ -0,0 +1,64 @@
+#include "sim_ooo.h"
+#include <chrono>
+
+using namespace std;
+
+// Times print_status() through cout field by field and through the buffered renderer,
+// on the sort program printed every cycle; the status goes to stdout, the timings to stderr
+// usage: print_bench [repetitions] > /dev/null
+
+static sim_ooo *build(){
+   sim_ooo *ooo = new sim_ooo(1024*1024, 6, 3, 2, 2, 2, 2);
+   ooo->init_exec_unit(INTEGER, 3, 2);
+   ooo->init_exec_unit(ADDER, 3, 2);
+   ooo->init_exec_unit(MULTIPLIER, 10, 1);
+   ooo->init_exec_unit(DIVIDER, 40, 1);
+   ooo->init_exec_unit(MEMORY, 5, 1);
+   ooo->load_program("asm/sort.asm", 0x00000000);
+   ooo->set_int_register(7, 0x80000000);
+   unsigned i, j;
+   for (i = 0xA000, j = 12; i < 0xA030; i += 4, j -= 1){
+      float value = j;
+      unsigned word;
+      memcpy(&word, &value, sizeof(word));
+      ooo->write_memory(i, word);
+   }
+   return ooo;
+}
+
+// Seconds spent in print_status() over a whole run, "repetitions" times
+static double timePrints(bool fast, unsigned repetitions, unsigned& calls){
+   double seconds = 0;
+   calls          = 0;
+   sim_ooo *reference = build();
+   reference->run();
+   unsigned cycles = reference->get_clock_cycles();
+   delete reference;
+
+   for (unsigned r = 0; r < repetitions; r++){
+      sim_ooo *ooo = build();
+      ooo->set_fast_print(fast);
+      for (unsigned c = 0; c < cycles; c++){
+         ooo->run(1);
+         chrono::steady_clock::time_point start = chrono::steady_clock::now();
+         ooo->print_status();
+         seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+         calls++;
+      }
+      delete ooo;
+   }
+   return seconds;
+}
+
+int main(int argc, char **argv){
+   unsigned repetitions = argc > 1 ? atoi(argv[1]) : 20;
+   unsigned calls;
+   double stream        = timePrints(false, repetitions, calls);
+   double fast          = timePrints(true, repetitions, calls);
+
+   cerr << "print_status() calls = " << calls << endl;
+   cerr << "cout field by field  = " << stream * 1e6 / calls << " us/call" << endl;
+   cerr << "buffered renderer    = " << fast * 1e6 / calls << " us/call" << endl;
+   cerr << "speedup              = " << stream / fast << "x" << endl;
+   return 0;
+}
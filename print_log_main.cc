@@ -0,0 +1,15 @@
+#include "sim_ooo.h"
+
+using namespace std;
+
+// Prints an execution log file written by sim_ooo::set_log_file()
+// usage: print_log <log file>
+int main(int argc, char **argv){
+   if( argc != 2 ){
+      cerr << "usage: " << argv[0] << " <log file>" << endl;
+      return 1;
+   }
+
+   print_log_file( argv[1] );
+   return 0;
+}
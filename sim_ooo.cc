@@ -1,15 +1,20 @@
 #include "sim_ooo.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
 //used for debugging purposes
 static const char *stage_names[NUM_STAGES] = {"ISSUE", "EXE", "WR", "COMMIT"};
-static const char *instr_names[NUM_OPCODES] = {"LW", "SW", "ADD", "ADDI", "SUB", "SUBI", "XOR", "XORI", "OR", "ORI", "AND", "ANDI", "MULT", "DIV", "BEQZ", "BNEZ", "BLTZ", "BGTZ", "BLEZ", "BGEZ", "JUMP", "EOP", "LWS", "SWS", "ADDS", "SUBS", "MULTS", "DIVS"};
+//indexed by opcode_t
+static const char *instr_names[NUM_OPCODES] = {"LW", "SW", "ADD", "SUB", "XOR", "OR", "AND", "MULT", "DIV", "ADDI", "SUBI", "XORI", "ORI", "ANDI", "BEQZ", "BNEZ", "BLTZ", "BGTZ", "BLEZ", "BGEZ", "JUMP", "EOP", "LWS", "SWS", "ADDS", "SUBS", "MULTS", "DIVS"};
 static const char *res_station_names[5]={"Int", "Load", "Add", "Mult"};
 
-map <string, opcode_t> opcode_2str = { {"LW", LW}, {"SW", SW}, {"ADD", ADD}, {"ADDI", ADDI}, {"SUB", SUB}, {"SUBI", SUBI}, {"XOR", XOR}, {"XORI", XORI}, {"OR", OR}, {"ORI", ORI}, {"AND", AND}, {"ANDI", ANDI}, {"MULT", MULT}, {"DIV", DIV}, {"BEQZ", BEQZ}, {"BNEZ", BNEZ}, {"BLTZ", BLTZ}, {"BGTZ", BGTZ}, {"BLEZ", BLEZ}, {"BGEZ", BGEZ}, {"JUMP", JUMP}, {"EOP", EOP}, {"LWS", LWS}, {"SWS", SWS}, {"ADDS", ADDS}, {"SUBS", SUBS}, {"MULTS", MULTS}, {"DIVS", DIVS}};
+//lookup tables are read-only so that simulator instances can run concurrently
 
-map <exe_unit_t, res_station_t> ex_2Rs = { {INTEGER, INTEGER_RS}, {ADDER, ADD_RS}, {MULTIPLIER, MULT_RS}, {DIVIDER, MULT_RS}, {MEMORY, LOAD_B} };
+//indexed by exe_unit_t
+static const res_station_t ex_2Rs[EX_TOTAL] = { INTEGER_RS, ADD_RS, MULT_RS, MULT_RS, LOAD_B };
 //------------------------------------convert functions begin--------------------------------------------------------------//
 /* convert a float into an unsigned */
 inline unsigned float2unsigned(float value){
@@ -45,44 +50,177 @@ sim_ooo::sim_ooo(unsigned mem_size,
                 unsigned num_add_res_stations,
                 unsigned num_mul_res_stations,
                 unsigned num_load_res_stations,
-                unsigned max_issue){
+                unsigned max_issue,
+                unsigned num_lsq_entries,
+                unsigned commit_width){
 
 	data_memory_size       = mem_size;
    robSize                = rob_size;
    issueWidth             = max_issue;
+   commitWidth            = commit_width;
+   ASSERT( commit_width > 0, "Commit width must be positive" );
+   cycleCount             = 0;
+   instCount              = 0;
+   instMemSize            = 0;
+   uops                   = NULL;
+   baseAddress            = 0;
 
    resStSize              = new unsigned[RS_TOTAL];
    resStSize[INTEGER_RS]  = num_int_res_stations;
    resStSize[ADD_RS]      = num_add_res_stations;
    resStSize[MULT_RS]     = num_mul_res_stations;
    resStSize[LOAD_B]      = num_load_res_stations;
+   for(int i = 0; i < RS_TOTAL; i++)
+      resStation[i].init(resStSize[i]);
 
    //Allocating issue queue, ROB, reservation stations
-	data_memory            = new unsigned char[data_memory_size];
    rob                    = Fifo<robT>( rob_size );
+   dInstPool.init( rob_size );
+   lsq.init( num_lsq_entries > 0 ? num_lsq_entries : rob_size );
+
+   // Per-cycle scratch space is sized up front so that run() does not allocate
+   unsigned numStations   = 0;
+   for(int i = 0; i < RS_TOTAL; i++)
+      numStations        += resStSize[i];
+   resGCUnit.reserve( numStations );
+   resGCIndex.reserve( numStations );
+   bypassLane.reserve( resStSize[LOAD_B] );
    gSquash                = false;
+   earlyRecovery          = false;
+   recoverTag             = UNDEFINED;
+   earlyRecoveries        = 0;
+   renameCkpts.resize( rob_size );
+   storeSetsOn            = false;
+   storeSets.init( 10, 128 );
+   replayTag              = UNDEFINED;
+   speculativeLoads       = 0;
+   memViolations          = 0;
+   loadReplays            = 0;
    memBlock               = false;
+   fetchSeq               = 0;
+   cycleSkipping          = true;
+   logMemory              = true;
+   fastPrint              = true;
+   programCache           = false;
+   programCached          = false;
+   skippedCycles          = 0;
+   functionalCount        = 0;
+   set_sampling(0, 0);
+   predictor.init(PREDICT_NOT_TAKEN, 12, 512);
 
    reset();
 }
 	
 sim_ooo::~sim_ooo(){
+   logSink.close();
+   trace.close();
+   free( uops );
 }
 
 void sim_ooo::init_exec_unit(exe_unit_t exec_unit, unsigned latency, unsigned instances){
    execFp[exec_unit].init(instances, latency);
+
+   // Events go at most latency + 1 cycles ahead of dispatch
+   unsigned horizon       = 0;
+   unsigned totalLanes    = 0;
+   for(int i = 0; i < EX_TOTAL; i++){
+      horizon             = max( horizon, (unsigned)execFp[i].latency + 2 );
+      totalLanes         += execFp[i].numLanes;
+   }
+   laneWheel.init( horizon, totalLanes );
+
+   // Micro-ops carry the unit latencies
+   decodeProgram();
+}
+
+// Whole file in one read
+static bool readFile(const char *filename, string& content){
+   ifstream in( filename, ifstream::in | ifstream::binary | ifstream::ate );
+   if( !in.is_open() )
+      return false;
+   content.resize( in.tellg() );
+   in.seekg( 0 );
+   in.read( &content[0], content.size() );
+   return in.good();
 }
 
 void sim_ooo::load_program(const char *filename, unsigned base_address){
-   instMemSize               = parse(string(filename), base_address);
+   string source;
+   ASSERT( readFile( filename, source ), "Unable to open file: %s", filename );
+
+   // Decoded programs are cached next to their source, keyed by a hash of the source text
+   uint64_t hash             = programHash( source.data(), source.size() );
+   string cacheFile          = string(filename) + ".cache";
+   programCached             = programCache && readProgramCache( cacheFile, hash );
+   if( programCached )
+      instMemSize            = instMemory.size();
+   else{
+      instMemSize            = parse( source.c_str(), source.size() );
+      if( programCache )
+         writeProgramCache( cacheFile, hash );
+   }
+
+   for(int i = 0; i < instMemSize; i++)
+      instMemory[i].pc       = base_address + 4*i;
    PC                        = base_address;
+   baseAddress               = base_address;
+   branchStats.assign( instMemSize, branchStatT() );
+   decodeProgram();
+}
+
+void sim_ooo::set_program_cache(bool enable){
+   programCache              = enable;
+}
+
+bool sim_ooo::get_program_cached(){
+   return programCached;
+}
+
+// Builds the micro-op of every instruction of the program
+void sim_ooo::decodeProgram(){
+   free( uops );
+   uops                      = NULL;
+   if( instMemSize == 0 )
+      return;
+   void *buffer;
+   ASSERT( posix_memalign( &buffer, alignof(microOpT), instMemSize * sizeof(microOpT) ) == 0, "Unable to allocate micro-ops" );
+   uops                      = (microOpT*)buffer;
+
+   for(int i = 0; i < instMemSize; i++){
+      microOpT *uop          = new (&uops[i]) microOpT();
+      uop->inst              = instMemory[i];
+      uop->unit              = opcodeToExUnit( uop->inst.opcode );
+      uop->station           = ex_2Rs[uop->unit];
+      uop->latency           = execFp[uop->unit].latency;
+      switch( uop->inst.opcode ){
+         case LW:
+         case LWS:            uop->execute = exLoad;    break;
+         case ADD ... DIV:
+         case ADDS ... DIVS:  uop->execute = exAlu;     break;
+         case ADDI ... ANDI:  uop->execute = exAluImm;  break;
+         case BLTZ:           uop->execute = exBltz;    break;
+         case BNEZ:           uop->execute = exBnez;    break;
+         case BEQZ:           uop->execute = exBeqz;    break;
+         case BGTZ:           uop->execute = exBgtz;    break;
+         case BGEZ:           uop->execute = exBgez;    break;
+         case BLEZ:           uop->execute = exBlez;    break;
+         case JUMP:           uop->execute = exJump;    break;
+         case SW:
+         case SWS:            uop->execute = exStore;   break;
+         default:             uop->execute = exNone;    break;
+      }
+   }
 }
 
-instructT sim_ooo::fetchInstruction ( unsigned pc ) {
+const microOpT& sim_ooo::fetchMicroOp( unsigned pc ){
    int      index     = (pc - this->baseAddress)/4;
    ASSERT((index >= 0) && (index < instMemSize), "out of bound access of instruction memory %d", index);
-   instructT instruct = *(instMemory[index]);
-   return instruct;
+   return uops[index];
+}
+
+// Micro-op of an instruction in flight
+const microOpT& sim_ooo::uopOf( const instructT *inst ){
+   return uops[(inst->pc - baseAddress) / 4];
 }
 
 uint32_t sim_ooo::regRename(unsigned reg, bool isF, uint32_t& tag, bool& ready){
@@ -109,51 +247,77 @@ uint32_t sim_ooo::regRename(unsigned reg, bool isF, uint32_t& tag, bool& ready){
 
 // The following function is for IF + ID + RR
 bool sim_ooo::fetch(){
-   for (int j = 0; j < issueWidth && !rob.isFull(); j++){
+   for (int j = 0; j < issueWidth; j++){
+      if( rob.isFull() ){
+         counters.issueStalls[STALL_ROB]++;
+         break;
+      }
+
       //fetching instruction according to PC
-      instructT instruct     = fetchInstruction ( PC );
+      const microOpT& uop    = fetchMicroOp( PC );
+      const instructT& instruct = uop.inst;
 
       if( instruct.opcode == EOP ){
          return false;
       }
 
-      //finding the execution unit of the opcode
-      exe_unit_t unit        = opcodeToExUnit(instruct.opcode);
-      res_station_t rUnit    = ex_2Rs[unit];
+      //execution unit and reservation station of the opcode, from decode
+      exe_unit_t unit        = uop.unit;
+      res_station_t rUnit    = uop.station;
+      ASSERT( execFp[unit].numLanes > 0, "No lanes found for opcode: %s", opcode_str[instruct.opcode].c_str());
 
-      // Assert for overflown reservation station
-      ASSERT(resStation[rUnit].size() <= resStSize[rUnit] , 
-            "Illegal resStation size found for %s (%lu > %u)", res_station_names[rUnit], resStation[rUnit].size(), resStSize[rUnit]);
-
-      //Checking if reservation station is not full 
-      if (resStation[rUnit].size() < resStSize[rUnit]) {
+      //Checking if reservation station (and load/store queue for memory operations) is not full 
+      if (!resStation[rUnit].isFull() && !(unit == MEMORY && lsq.isFull())) {
          robT robEntry;
 
-         dynInstructPT dInstP   = new dynInstructT(instruct);
+         dynInstructPT dInstP   = dInstPool.alloc(instruct);
          dInstP->stat.state     = ISSUE;
          dInstP->stat.t_issue   = cycleCount;
+         dInstP->pred.history   = predictor.history;
+         if( trace.isOpen() ){
+            dInstP->traceId     = trace.issue(*dInstP, cycleCount);
+            traceStage(dInstP, ISSUE);
+         }
 
          robEntry.dInstP        = dInstP;
 
          if(instruct.is_store)
-            robEntry.memLatency = execFp[MEMORY].latency;
+            robEntry.memLatency = uop.latency;
 
          uint32_t robIndex      = rob.push(robEntry);
 
-         resStationT* resP      = new resStationT();
+         if( unit == MEMORY ){
+            int lsqIndex        = lsq.push(robIndex, instruct.is_store);
+            rob.peekIndex(robIndex)->lsqIndex = lsqIndex;
+            if( storeSetsOn )
+               predictDependence(lsqIndex, instruct);
+         }
+
+         resStationT* resP      = resStation[rUnit].alloc();
 
          resP->dInstP           = dInstP;
+         resP->age              = fetchSeq++;
 
-         // Rename source operands
+         // Rename source operands and register as a consumer of pending producers
          if( instruct.src1Valid ){
             uint32_t qj;
             resP->vj            = regRename(instruct.src1, instruct.src1F, qj, resP->vjR);
             resP->qj            = qj;
+            if( !resP->vjR ){
+               robT* prodP      = rob.peekIndex(qj);
+               resP->jNext      = prodP->jConsumers;
+               prodP->jConsumers = resP;
+            }
          }
          if( instruct.src2Valid ){
             uint32_t qk;
             resP->vk            = regRename(instruct.src2, instruct.src2F, qk, resP->vkR);
             resP->qk            = qk;
+            if( !resP->vkR ){
+               robT* prodP      = rob.peekIndex(qk);
+               resP->kNext      = prodP->kConsumers;
+               prodP->kConsumers = resP;
+            }
          }
          resP->tagD             = robIndex;
 
@@ -161,23 +325,27 @@ bool sim_ooo::fetch(){
          if( unit == MEMORY )
             resP->addr          = instruct.imm;
 
-         // Get the id
-         vector<resStationT*> resSt = resStation[rUnit];
-         sort(resSt.begin(), resSt.end(), resStSort);
-         int id                 = resSt.size();
-         for( int index = 0; index < (int)resSt.size(); index++ ){
-            if( resSt[index]->id != index ){
-               id               = index;
-               break;
+         if( instruct.is_store && resP->vkR )
+            recordStoreAddress(resP);
+         if( resP->vjR && resP->vkR )
+            operandsReady(resP);
+
+         //moving on to the next instruction, or to the predicted target of a branch,
+         //only if ROB and RS are not full
+         PC                     = instruct.is_branch ? predictBranch(instruct, dInstP->pred) : PC + 4;
+
+         //rename map to recover from if the branch was mispredicted
+         if( instruct.is_branch && earlyRecovery ){
+            renameCkptT& ckpt   = renameCkpts[robIndex];
+            for(int i = 0; i < NUM_GP_REGISTERS; i++){
+               ckpt.gprBusy[i]  = gprFile[i].busy;
+               ckpt.gprTag[i]   = gprFile[i].tag;
+            }
+            for(int i = 0; i < NUM_FP_REGISTERS; i++){
+               ckpt.fpBusy[i]   = fpFile[i].busy;
+               ckpt.fpTag[i]    = fpFile[i].tag;
             }
          }
-         resP->id               = id;
-
-         // Add an entry in reservation station
-         resStation[rUnit].push_back( resP );
-
-         //incrementing PC only if ROB and RS are not full
-         PC                     = PC + 4;
 
          //update TAG at register File with ROB entry if destination exists
          if(instruct.dstValid){
@@ -189,116 +357,231 @@ bool sim_ooo::fetch(){
       }
       else{
          // Reservation station is full
+         counters.issueStalls[resStation[rUnit].isFull() ? STALL_RS : STALL_LSQ]++;
          break;
       }
-      //Break if Branch to create a basic block
-      //Since BP = always not taken, do nothing
+      //A branch predicted taken ends the fetch group
+      if( PC != instruct.pc + 4 )
+         break;
    }
    return true;
 }
 
+// Next PC after a branch: its target if predicted taken and in the BTB, the next instruction otherwise
+uint32_t sim_ooo::predictBranch(const instructT& instruct, branchPredT& pred){
+   pred.nextPC            = instruct.pc + 4;
+   pred.taken             = false;
+   pred.provider          = -1;
+   if( predictor.type == PREDICT_NOT_TAKEN )
+      return pred.nextPC;
+
+   // Jumps are always taken and stay out of the direction tables and history
+   if( instruct.opcode == JUMP )
+      pred.taken          = true;
+   else
+      predictor.predict(instruct.pc, pred);
+   uint32_t target;
+   if( pred.taken && predictor.target(instruct.pc, target) )
+      pred.nextPC         = target;
+   return pred.nextPC;
+}
+
+void sim_ooo::trainBranch(const instructT* inst, const branchPredT& pred, bool taken, uint32_t target){
+   if( predictor.type == PREDICT_NOT_TAKEN )
+      return;
+   if( inst->opcode != JUMP )
+      predictor.train(pred, taken);
+   if( taken )
+      predictor.setTarget(inst->pc, target);
+}
+
+// Counts a committing branch and trains the predictor with its outcome
+void sim_ooo::retireBranch(robT* robP){
+   dynInstructPT dInstP      = robP->dInstP;
+   branchStatT& stat         = branchStats[(dInstP->pc - baseAddress) / 4];
+   stat.executed++;
+   stat.taken               += dInstP->is_taken;
+   stat.mispredicted        += robP->misPred;
+   trainBranch(dInstP, dInstP->pred, dInstP->is_taken, robP->value);
+}
+
+// Called once a station has all of its operands: queue it for select
+void sim_ooo::operandsReady(resStationT* resP){
+   readyList[uopOf(resP->dInstP).unit].insert(resP);
+}
+
+// Record store address as soon as its base is known, for disambiguation
+void sim_ooo::recordStoreAddress(resStationT* resP){
+   uint32_t addr            = agen(resP);
+   robT* robP               = rob.peekIndex( resP->tagD );
+   robP->dest               = addr;
+   lsq.resolve( robP->lsqIndex, addr );
+
+   // Younger loads may have gone ahead of the store to the same location
+   if( storeSetsOn ){
+      int loadIdx           = lsq.violatedLoad( robP->lsqIndex );
+      if( loadIdx != -1 )
+         memoryViolation( robP->lsqIndex, loadIdx );
+   }
+}
+
+// Store set of a memory instruction at fetch: a store becomes the last fetched
+// store of its set, a load of a set depends on that store while it is in flight
+void sim_ooo::predictDependence(int lsqIndex, const instructT& instruct){
+   storeSets.tick();
+   int set                  = storeSets.setOf( instruct.pc );
+   if( set == -1 )
+      return;
+   if( instruct.is_store ){
+      storeSets.lfstIdx[set] = lsqIndex;
+      storeSets.lfstSeq[set] = lsq.entries[lsqIndex].seq;
+   }
+   else if( storeSets.lfstIdx[set] != -1 && lsq.holds( storeSets.lfstIdx[set], storeSets.lfstSeq[set] ) ){
+      lsq.entries[lsqIndex].depIdx = storeSets.lfstIdx[set];
+      lsq.entries[lsqIndex].depSeq = storeSets.lfstSeq[set];
+   }
+}
+
+// A load leaves for execution
+void sim_ooo::issueLoad(resStationT* resP, bool speculative){
+   lsq.issueLoad( rob.peekIndex( resP->tagD )->lsqIndex, agen(resP), speculative );
+   speculativeLoads        += speculative;
+}
+
+// The store in storeIdx writes where the younger load in loadIdx already read:
+// both go in the same store set and the pipeline is squashed from the load at
+// the end of the cycle (from the oldest such load)
+void sim_ooo::memoryViolation(int storeIdx, int loadIdx){
+   unsigned loadTag         = lsq.entries[loadIdx].robTag;
+   memViolations++;
+   storeSets.train( rob.peekIndex( lsq.entries[storeIdx].robTag )->dInstP->pc, rob.peekIndex( loadTag )->dInstP->pc );
+   if( replayTag == UNDEFINED || robDistance(loadTag) < robDistance(replayTag) )
+      replayTag             = loadTag;
+}
+
 // The following function is for IS
 bool sim_ooo::dispatch(){
    bool status = false;
-   //To iterate through reservation station units
-   for(int unit = 0; unit < RS_TOTAL; unit++) {
-      //To iterate through individual units
-      for(unsigned payIndex = 0; payIndex < resStation[unit].size(); payIndex++) {
-         status                = true;
-         //Checking if both operands are ready, hence instruction is ready and it is not in execute stage
-         resStationT* resP     = resStation[unit][payIndex];
+   unsigned held = 0;
+   for(int unit = 0; unit < RS_TOTAL; unit++)
+      status               |= resStation[unit].count > 0;
+
+   //Only stations whose operands are ready are looked at, oldest first
+   for(int execUnit = 0; execUnit < EX_TOTAL; execUnit++) {
+      int numLanes         = execFp[execUnit].numLanes;
+      bool isMem           = execUnit == MEMORY;
+      resStationT* next;
+      for(resStationT* resP = readyList[execUnit].head; resP != NULL; resP = next) {
+         next                  = resP->readyNext;
 
          bool instReady        = true;
          bool bypassReady      = false;
          uint32_t bypassValue  = UNDEFINED;
+         bool speculative      = false;
          bool is_store         = resP->dInstP->is_store;
          bool is_load          = resP->dInstP->is_load;
-         uint32_t addr         = agen(resP);
-         
+
          if( is_load ){
-            instReady      = !isConflictingStore(resP->tagD, addr, bypassReady, bypassValue);
+            instReady      = !isConflictingStore(resP->tagD, agen(resP), bypassReady, bypassValue, speculative);
          } 
 
-         // Record address as soon as we can for disambiguation
-         if( is_store && resP->vkR ){
-            rob.peekIndex( resP->tagD )->dest       = addr;
+         if ( !instReady ){
+            held          |= 1 << STALL_STORE_CONFLICT;
+            continue;
          }
 
-         if ( !resP->inExec && resP->vjR && resP->vkR && instReady ){
-            int execUnit   = opcodeToExUnit(resP->dInstP->opcode);
-            int numLanes   = execFp[execUnit].numLanes;
-            bool isMem     = execUnit == MEMORY;
-                  
-            //TODO: check
-            if( is_store || bypassReady ){
-               // Go in bypass lane
-               resP->inExec                                     = true;
-               execWrLaneT lane;
-               lane.payloadP                                    = resP;
-               lane.outputReady                                 = is_load && bypassReady;
-               lane.output                                      = (is_load && bypassReady) ? bypassValue : UNDEFINED;
-               bypassLane.push_back( lane );
-            }
-            else{
-               // Try to go in regular lanes
-               for(int laneId = 0; laneId < numLanes; laneId++){
-                  //checking for free execution units
-                  if(execFp[execUnit].lanes[laneId].ttl == 0 && ((isMem && !memBlock) || !isMem)){
-                     resP->inExec                               = true;
-                     execFp[execUnit].lanes[laneId].payloadP    = resP;
-                     // How much time will the operation take to complete
-                     // 1. Stores take 1 cycle
-                     // 2. Bypassed loads take 1 cycle
-                     // 3. Remaining takes set cycles
-                     uint32_t ttl                               = execFp[execUnit].latency;
-                     // Adding 1 to model 1 unit latency in Write Result
-
-                     execFp[execUnit].lanes[laneId].ttl         = ttl + 1;
-
-                     // Setting up outputs
-                     execFp[execUnit].lanes[laneId].outputReady = false;
-                     execFp[execUnit].lanes[laneId].output      = UNDEFINED;
-                     break;
-                  }
-               }
+         //TODO: check
+         if( is_store || bypassReady ){
+            // Go in bypass lane
+            resP->inExec                                     = true;
+            readyList[execUnit].remove(resP);
+            execWrLaneT lane;
+            lane.payloadP                                    = resP;
+            lane.outputReady                                 = is_load && bypassReady;
+            lane.output                                      = (is_load && bypassReady) ? bypassValue : UNDEFINED;
+            bypassLane.push_back( lane );
+            if( is_load )
+               issueLoad(resP, speculative);
+            continue;
+         }
+
+         // Try to go in regular lanes
+         bool issued           = false;
+         for(int laneId = 0; laneId < numLanes; laneId++){
+            //checking for free execution units
+            if(!execFp[execUnit].lanes[laneId].busy && ((isMem && !memBlock) || !isMem)){
+               resP->inExec                               = true;
+               readyList[execUnit].remove(resP);
+               execFp[execUnit].lanes[laneId].payloadP    = resP;
+               execFp[execUnit].lanes[laneId].busy        = true;
+               if( is_load )
+                  issueLoad(resP, speculative);
+               // How much time will the operation take to complete
+               // 1. Stores take 1 cycle
+               // 2. Bypassed loads take 1 cycle
+               // 3. Remaining takes set cycles
+               unsigned latency                           = execFp[execUnit].latency;
+               exe_unit_t unitE                           = (exe_unit_t)execUnit;
+
+               // Execution starts next cycle and produces the output in its
+               // last cycle, plus 1 unit latency in Write Result
+               if( latency > 1 )
+                  laneWheel.schedule( cycleCount + 1, unitE, laneId, LANE_EXEC );
+               laneWheel.schedule( cycleCount + latency, unitE, laneId, LANE_OUTPUT );
+               laneWheel.schedule( cycleCount + latency + 1, unitE, laneId, LANE_WR );
+
+               // Setting up outputs
+               execFp[execUnit].lanes[laneId].outputReady = false;
+               execFp[execUnit].lanes[laneId].output      = UNDEFINED;
+               issued                                     = true;
+               break;
             }
          }
+
+         if( !issued )
+            held          |= 1 << (isMem && memBlock ? STALL_MEM_BLOCK : STALL_LANE_BUSY);
+
+         // All lanes are busy, younger ready stations cannot go either
+         // (loads may still take the bypass lane)
+         if( !issued && !isMem )
+            break;
       }
    }
+   counters.dispatchStalled(held, 1);
    return status;
 }
 
 //checking for conflicting store with a load instruction
-bool sim_ooo::isConflictingStore(int loadTag, unsigned memAddress, bool& bypassReady, uint32_t& bypassValue){
-   bool conflict               = false;
+//Only the youngest older store that has an unknown address or matches the
+//load address matters, and the load/store queue finds it directly
+//With store sets, a load not predicted to depend on a store whose address is
+//unknown looks past such stores ("speculative" is then set)
+bool sim_ooo::isConflictingStore(int loadTag, unsigned memAddress, bool& bypassReady, uint32_t& bypassValue, bool& speculative){
    bypassReady                 = false;
-   for(int i = 0; i < rob.getCount(); i++){
-      //getting the current tag
-      int tag                  = rob.genIndex(i);
-      //Get the ROB entry
-      robT* robEntryP          = rob.peekNth(i);
-
-      //checking if the opcode is store
-      if( robEntryP->dInstP->is_store ){
-         //if the store is not complete (a.k.a ??), then there is a conflict
-         if( robEntryP->dest == UNDEFINED ){
-            conflict           = true;
-            bypassReady        = false;
-         }
-         //if store is complete and match the address, no conflict.
-         //values are stored from this store to load temporarily
-         else if(robEntryP->dest == memAddress){
-            conflict           = !robEntryP->ready; // TODO: not conflicting if rob is ready
-            bypassReady        = robEntryP->ready;  // bypass is ready if rob is ready
-            bypassValue        = robEntryP->value;
-         }
-      }
-      if(tag == loadTag)
-         //returns the most recent conflict entry
-         return conflict;
+   speculative                 = false;
+   int loadIdx                 = rob.peekIndex(loadTag)->lsqIndex;
+   ASSERT( loadIdx != -1, "Load (tag=%d) not found in load/store queue", loadTag );
+
+   int storeIdx                = lsq.youngestOlderStore(loadIdx, memAddress);
+   if( storeIdx == -1 )
+      return false;
+
+   //if the store address is not known yet, then there is a conflict
+   if( !lsq.entries[storeIdx].addrValid ){
+      if( !storeSetsOn || lsq.waitsOnStore(loadIdx) )
+         return true;
+      speculative              = true;
+      storeIdx                 = lsq.youngestOlderMatch(loadIdx, memAddress);
+      if( storeIdx == -1 )
+         return false;
    }
-   ASSERT(true, "tag == loadTag not found!");
-   return conflict;
+
+   //if store matches the address and is complete, no conflict.
+   //values are stored from this store to load temporarily
+   robT* storeP                = rob.peekIndex(lsq.entries[storeIdx].robTag);
+   bypassReady                 = storeP->ready;
+   bypassValue                 = storeP->value;
+   return !storeP->ready;
 }
 
 //-------------------------------issue stage begin-----------------------------------------------------------//
@@ -316,6 +599,7 @@ void sim_ooo::doExec(execWrLaneT* laneP, bool doWr){
    if( resP->dInstP->stat.state != EXECUTE ){
       resP->dInstP->stat.state     = EXECUTE;
       resP->dInstP->stat.t_execute = cycleCount;
+      traceStage(resP->dInstP, EXECUTE);
    }
    bool is_store                 = resP->dInstP->is_store;
    bool is_load                  = resP->dInstP->is_load;
@@ -327,7 +611,13 @@ void sim_ooo::doExec(execWrLaneT* laneP, bool doWr){
       // 1 implies Write Result
       // It's time to execute!!
       if( !laneP->outputReady ){
-         laneP->output           = aluGetOutput(resP->dInstP, resP->vj, resP->vk, resP->addr, rob.peekIndex( resP->tagD )->misPred);
+         bool taken;
+         laneP->output           = uopOf(resP->dInstP).execute(this, resP->dInstP, resP->vj, resP->vk, resP->addr, taken);
+         // A branch that did not go where fetch went squashes at commit
+         if( resP->dInstP->is_branch ){
+            resP->dInstP->is_taken                  = taken;
+            rob.peekIndex( resP->tagD )->misPred    = laneP->output != resP->dInstP->pred.nextPC;
+         }
       }
       // vk has to be updated for all loads
       else if( is_load )
@@ -341,187 +631,175 @@ bool sim_ooo::execute(){
    bool status = false;
    //TODO: check it
    // Check bypass lanes
-   for( int i = 0; i < bypassLane.size(); i++ ){
+   for( unsigned i = 0; i < bypassLane.size(); i++ ){
       status  = true;
       doExec( &(bypassLane[i]), true );
    }
 
-   //iterating through execution units
-   for(int i = 0; i < EX_TOTAL; i++){
-      //iterating through number of instances of an EXEC UNIT
-      for(int j = 0; j < execFp[i].numLanes; j++){
-         execWrLaneT* laneP = &(execFp[i].lanes[j]);
-         //Checking if TTL of the lane is not zero
-         if( laneP->ttl  > 0 ){
-            status = true;
-            doExec( laneP, laneP->ttl == 1 );
-         }
-      }
+   //only lanes starting or producing their output this cycle
+   unsigned numEvents;
+   laneEventT* events = laneWheel.bucket( cycleCount, numEvents );
+   for( unsigned i = 0; i < numEvents; i++ ){
+      if( events[i].kind == LANE_WR )
+         continue;
+      status = true;
+      doExec( &(execFp[events[i].unit].lanes[events[i].lane]), events[i].kind == LANE_OUTPUT );
    }
+   laneWheel.drain( cycleCount );
    return status;
 }
 
-uint32_t sim_ooo::aluGetOutput(dynInstructT* dInstP, unsigned src1V, unsigned src2V, uint32_t addr, bool& misPred){
-   bool src1F      = dInstP->src1F;
-   bool src2F      = dInstP->src2F;
-   opcode_t opcode = dInstP->opcode;
-   uint32_t imm    = dInstP->imm;
-   uint32_t npc    = dInstP->pc + 4;
-   unsigned aluOut = UNDEFINED;
-   misPred         = false;
-
-   switch(opcode) {
-      case LW:
-      case LWS:
-         aluOut  = read_memory (addr);
-         break;
+// Execute handlers, picked per instruction by decodeProgram()
+uint32_t sim_ooo::exLoad(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken){
+   taken         = false;
+   return sim->read_memory(addr);
+}
 
-      case ADD ... DIV:
-      case ADDS ... DIVS:
-         aluOut  = alu(src1V, src2V, src1F, src2F, opcode);
-         break;
+uint32_t sim_ooo::exAlu(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken){
+   taken         = false;
+   return sim->alu(src1V, src2V, inst->src1F, inst->src2F, inst->opcode);
+}
 
-      case ADDI ... ANDI:
-         aluOut  = alu(src1V, imm, src1F, false, opcode);
-         break;
+uint32_t sim_ooo::exAluImm(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken){
+   taken         = false;
+   return sim->alu(src1V, inst->imm, inst->src1F, false, inst->opcode);
+}
 
-      case BLTZ:
-         misPred = src1V < 0;
-         aluOut  = misPred ? alu(npc, imm, false, false, opcode) : npc;
-         break;
+// Branches: the target when taken, the next PC otherwise (src1V is unsigned, as it always was)
+uint32_t sim_ooo::exBltz(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken){
+   taken         = src1V < 0;
+   return taken ? sim->alu(inst->pc + 4, inst->imm, false, false, inst->opcode) : inst->pc + 4;
+}
 
-      case BNEZ:
-         misPred = src1V != 0;
-         aluOut  = misPred ? alu(npc, imm, false, false, opcode) : npc;
-         break;
+uint32_t sim_ooo::exBnez(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken){
+   taken         = src1V != 0;
+   return taken ? sim->alu(inst->pc + 4, inst->imm, false, false, inst->opcode) : inst->pc + 4;
+}
 
-      case BEQZ:
-         misPred = src1V == 0;
-         aluOut  = misPred ? alu(npc, imm, false, false, opcode) : npc;
-         break;
+uint32_t sim_ooo::exBeqz(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken){
+   taken         = src1V == 0;
+   return taken ? sim->alu(inst->pc + 4, inst->imm, false, false, inst->opcode) : inst->pc + 4;
+}
 
-      case BGTZ:
-         misPred = src1V > 0;
-         aluOut  = misPred ? alu(npc, imm, false, false, opcode) : npc;
-         break;
+uint32_t sim_ooo::exBgtz(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken){
+   taken         = src1V > 0;
+   return taken ? sim->alu(inst->pc + 4, inst->imm, false, false, inst->opcode) : inst->pc + 4;
+}
 
-      case BGEZ:
-         misPred = src1V >= 0;
-         aluOut  = misPred ? alu(npc, imm, false, false, opcode) : npc;
-         break;
+uint32_t sim_ooo::exBgez(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken){
+   taken         = src1V >= 0;
+   return taken ? sim->alu(inst->pc + 4, inst->imm, false, false, inst->opcode) : inst->pc + 4;
+}
 
-      case BLEZ:
-         misPred = src1V <= 0;
-         aluOut  = misPred ? alu(npc, imm, false, false, opcode) : npc;
-         break;
+uint32_t sim_ooo::exBlez(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken){
+   taken         = src1V <= 0;
+   return taken ? sim->alu(inst->pc + 4, inst->imm, false, false, inst->opcode) : inst->pc + 4;
+}
 
-      case JUMP:
-         misPred = true;
-         aluOut  = alu(npc, imm, false, false, opcode);
-         break;
+uint32_t sim_ooo::exJump(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken){
+   taken         = true;
+   return sim->alu(inst->pc + 4, inst->imm, false, false, inst->opcode);
+}
 
-      case SW:
-      case SWS:
-         aluOut = src1V;
-         break;
-      case EOP:
-         break;
+uint32_t sim_ooo::exStore(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken){
+   taken         = false;
+   return src1V;
+}
 
-      default:
-         ASSERT(false, "Unknown operation encountered");
-         break;
-   }
-   return aluOut;
+uint32_t sim_ooo::exNone(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken){
+   taken         = false;
+   return UNDEFINED;
 }
 //-----------------------------------WRITE RESULT STAGE MOSTLY---------------------------------------------//
 void sim_ooo::wakeupAndRob(resStationT* resP, uint32_t output, vector<res_station_t>& resGCUnit, vector<int>& resGCIndex){
-   int resDelIndex       = -1;
-   res_station_t resDelUnit;
-   //wake up all res stations by searching for tagD
-   for( int unit = 0; unit < RS_TOTAL; unit++ ){
-      for(uint32_t k = 0; k < resStation[unit].size(); k++) {
-         resStationT* resWakeP   = resStation[unit][k];
-
-         if( resP->tagD == resWakeP->tagD ){
-            resDelIndex          = k;
-            resDelUnit           = (res_station_t)unit;
-         }
-
-         if(resWakeP->qj == resP->tagD) {
-            resWakeP->vj  = output;
-            resWakeP->vjR = true;
-            resWakeP->qj  = UNDEFINED;
-         }
-         if(resWakeP->qk == resP->tagD) {
-            resWakeP->vk  = output;
-            resWakeP->vkR = true;
-            resWakeP->qk  = UNDEFINED;
-            //TODO: check if its needed
-            //if( resWakeP->dInstP->is_store ){
-            //   rob.peekIndex( resWakeP->tagD )->dest = agen(resWakeP);
-            //}
-         }
-      }
+   robT* robP            = rob.peekIndex( resP->tagD );
+
+   //wake up only the stations registered on tagD at rename
+   for( resStationT* resWakeP = robP->jConsumers; resWakeP != NULL; resWakeP = resWakeP->jNext ){
+      resWakeP->vj  = output;
+      resWakeP->vjR = true;
+      resWakeP->qj  = UNDEFINED;
+      if( resWakeP->vkR )
+         operandsReady(resWakeP);
+   }
+   for( resStationT* resWakeP = robP->kConsumers; resWakeP != NULL; resWakeP = resWakeP->kNext ){
+      resWakeP->vk  = output;
+      resWakeP->vkR = true;
+      resWakeP->qk  = UNDEFINED;
+      if( resWakeP->dInstP->is_store )
+         recordStoreAddress(resWakeP);
+      if( resWakeP->vjR )
+         operandsReady(resWakeP);
    }
+   robP->jConsumers      = NULL;
+   robP->kConsumers      = NULL;
+
    // updating ROB
-   rob.peekIndex( resP->tagD )->value = output;
-   rob.peekIndex( resP->tagD )->ready = true;
+   robP->value           = output;
+   robP->ready           = true;
 
    //remove entry from res station
-   ASSERT( resDelIndex != -1, "resDelIndex == -1" );
+   res_station_t resDelUnit = uopOf(resP->dInstP).station;
    resGCUnit.push_back( resDelUnit );
-   resGCIndex.push_back( resDelIndex );
+   resGCIndex.push_back( resP->id );
 }
 
 bool sim_ooo::writeResult(vector<res_station_t>& resGCUnit, vector<int>& resGCIndex){
    bool status = false;
-   vector<int> bypassDelIndex;
+   // Completed bypass lanes are dropped by compacting the survivors in place
+   unsigned keep = 0;
 
-   for( int i = 0; i < bypassLane.size(); i++ ){
+   for( unsigned i = 0; i < bypassLane.size(); i++ ){
       resStationT* resP             = bypassLane[i].payloadP;
       if( resP->dInstP->stat.state == EXECUTE ){
          status                       = true;
          resP->dInstP->stat.state     = WRITE_RESULT;
          resP->dInstP->stat.t_wr      = cycleCount;
+         traceStage(resP->dInstP, WRITE_RESULT);
          wakeupAndRob( resP, bypassLane[i].output, resGCUnit, resGCIndex );
-         // Delete this lane now
-         bypassDelIndex.push_back(i);
+      }
+      else{
+         bypassLane[keep++]           = bypassLane[i];
       }
    }
-
-   // Delete
-   int erase = 0;
-   for( int i = 0; i < bypassDelIndex.size(); i++ ){
-      bypassLane.erase( bypassLane.begin() + i - erase  );
-      erase++;
-   }
-
-   for(int i = 0; i < EX_TOTAL; i++){
-      for(int j = 0; j < execFp[i].numLanes; j++){
-         if(execFp[i].lanes[j].ttl > 0){
-            execFp[i].lanes[j].ttl--;
-            if(execFp[i].lanes[j].ttl == 0){
-               status                    = true;
-               resStationT* resP         = execFp[i].lanes[j].payloadP;
-               execWrLaneT* laneP        = &(execFp[i].lanes[j]);
-
-               resP->dInstP->stat.state  = WRITE_RESULT;
-               resP->dInstP->stat.t_wr   = cycleCount;
-
-               ASSERT( laneP->outputReady, "At WriteResult, output not ready!" );
-
-               wakeupAndRob( resP, laneP->output, resGCUnit, resGCIndex );
-            }
-         }
+   bypassLane.resize( keep );
+
+   //only lanes finishing this cycle
+   unsigned numEvents;
+   laneEventT* events = laneWheel.bucket( cycleCount, numEvents );
+   for( unsigned i = 0; i < numEvents; i++ ){
+      if( events[i].kind != LANE_WR )
+         continue;
+      status                    = true;
+      execWrLaneT* laneP        = &(execFp[events[i].unit].lanes[events[i].lane]);
+      resStationT* resP         = laneP->payloadP;
+      laneP->busy               = false;
+
+      resP->dInstP->stat.state  = WRITE_RESULT;
+      resP->dInstP->stat.t_wr   = cycleCount;
+      traceStage(resP->dInstP, WRITE_RESULT);
+
+      ASSERT( laneP->outputReady, "At WriteResult, output not ready!" );
+
+      wakeupAndRob( resP, laneP->output, resGCUnit, resGCIndex );
+
+      // The oldest mispredicted branch resolved this cycle is recovered from at the end of it
+      if( earlyRecovery && resP->dInstP->is_branch && rob.peekIndex( resP->tagD )->misPred ){
+         if( recoverTag == UNDEFINED || robDistance(resP->tagD) < robDistance(recoverTag) )
+            recoverTag          = resP->tagD;
       }
    }
    return status;
 }
 
+// Retires up to commitWidth ready instructions from the ROB head, in order.
+// A store retires only from the head and ends the group once written, and a
+// mispredicted branch ends it too: the instructions after it get squashed
+// (with early recovery they already were, when the branch wrote its result)
 bool sim_ooo::commit(int& popCount){
    bool status     = false;
    popCount        = 0;
-   int commitWidth = 1; //FIXME: issueWidth;
+   int startCount  = instCount;
    for(int i = 0; (i < commitWidth) && (i < rob.getCount()); i++){
       // Get the pseudo-head
       robT* head       = rob.peekNth(i);
@@ -529,7 +807,8 @@ bool sim_ooo::commit(int& popCount){
       status           = true;
       if(head->ready){
          if(head->dInstP->is_store) {
-            if( execFp[MEMORY].lanes[0].ttl != 0 ){
+            // The memory access starts at the head, after the older instructions retired
+            if( i > 0 || execFp[MEMORY].lanes[0].busy ){
                break;
             }
             memBlock                 = true;
@@ -538,6 +817,7 @@ bool sim_ooo::commit(int& popCount){
          if( head->dInstP->stat.state != COMMIT ){
             head->dInstP->stat.state    = COMMIT;
             head->dInstP->stat.t_commit = cycleCount;
+            traceStage(head->dInstP, COMMIT);
          }
 
          //--------------- STORE ---------------
@@ -554,7 +834,9 @@ bool sim_ooo::commit(int& popCount){
 
 
          instCount++;
-         gSquash      = head->dInstP->is_branch && head->misPred;
+         if( head->dInstP->is_branch )
+            retireBranch(head);
+         gSquash      = head->dInstP->is_branch && head->misPred && !earlyRecovery;
 
          // Update RF
          if(head->dInstP->dstValid){
@@ -580,69 +862,326 @@ bool sim_ooo::commit(int& popCount){
 
          // Commit
          popCount++;
+         if(head->dInstP->is_store)
+            break;
       }
       else{
          // Instruction at pseudo-head is not ready
          break;
       }
    }
+
+   if( instCount == startCount ){
+      if( rob.isEmpty() )
+         counters.commitStalls[STALL_ROB_EMPTY]++;
+      else
+         counters.commitStalls[rob.peekHead()->ready ? STALL_STORE_MEMORY : STALL_NOT_READY]++;
+   }
    return status;
 }
 
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------------------CYCLE-SKIPPING----------------------------------------------//
+// True if fetch cannot bring in anything this cycle
+bool sim_ooo::fetchBlocked(){
+   if( rob.isFull() )
+      return true;
+   const microOpT& uop    = fetchMicroOp( PC );
+   if( uop.inst.opcode == EOP )
+      return true;
+   return resStation[uop.station].isFull() || (uop.unit == MEMORY && lsq.isFull());
+}
+
+// True if dispatch would send at least one ready station to execution
+bool sim_ooo::canSelect(){
+   for(int execUnit = 0; execUnit < EX_TOTAL; execUnit++) {
+      bool isMem           = execUnit == MEMORY;
+      for(resStationT* resP = readyList[execUnit].head; resP != NULL; resP = resP->readyNext) {
+         bool bypassReady      = false;
+         uint32_t bypassValue  = UNDEFINED;
+         bool speculative;
+         if( resP->dInstP->is_store )
+            return true;
+         if( resP->dInstP->is_load && isConflictingStore(resP->tagD, agen(resP), bypassReady, bypassValue, speculative) )
+            continue;
+         if( bypassReady )
+            return true;
+         for(int laneId = 0; laneId < execFp[execUnit].numLanes; laneId++){
+            if(!execFp[execUnit].lanes[laneId].busy && (!isMem || !memBlock))
+               return true;
+         }
+      }
+   }
+   return false;
+}
+
+// Number of upcoming cycles in which nothing happens but lanes counting down
+// towards write result and a committing store counting down its memory latency
+// (0 if the next cycle may do anything else)
+unsigned sim_ooo::idleCycles(){
+   if( rob.isEmpty() || !bypassLane.empty() )
+      return 0;
+
+   unsigned skip          = UNDEFINED;
+
+   // Lanes must not start, produce their output or write their result
+   unsigned nextLane      = laneWheel.nextEvent( cycleCount );
+   if( nextLane == 0 )
+      return 0;
+   skip                   = min( skip, nextLane );
+
+   // Commit may only be waiting: on a head that is not ready, or on a store
+   // that already started committing and is not about to finish
+   robT* head             = rob.peekHead();
+   if( head->ready ){
+      if( !head->dInstP->is_store )
+         return 0;
+      if( !execFp[MEMORY].lanes[0].busy ){
+         if( head->dInstP->stat.state != COMMIT || head->memLatency <= 1 )
+            return 0;
+         skip               = min( skip, head->memLatency - 1 );
+      }
+   }
+
+   if( !fetchBlocked() || canSelect() )
+      return 0;
+
+   return skip == UNDEFINED ? 0 : skip;
+}
+
+// Reasons (one bit per dispatch_stall_t) why the ready stations cannot go,
+// evaluated like dispatch() but without side effects
+unsigned sim_ooo::dispatchHeld(){
+   unsigned held          = 0;
+   for(int execUnit = 0; execUnit < EX_TOTAL; execUnit++) {
+      bool isMem           = execUnit == MEMORY;
+      for(resStationT* resP = readyList[execUnit].head; resP != NULL; resP = resP->readyNext) {
+         bool bypassReady      = false;
+         uint32_t bypassValue  = UNDEFINED;
+         bool speculative;
+         if( resP->dInstP->is_load && isConflictingStore(resP->tagD, agen(resP), bypassReady, bypassValue, speculative) )
+            held          |= 1 << STALL_STORE_CONFLICT;
+         else
+            held          |= 1 << (isMem && memBlock ? STALL_MEM_BLOCK : STALL_LANE_BUSY);
+      }
+   }
+   return held;
+}
+
+// Adds the current lane, ROB and reservation station usage for "cycles" cycles
+void sim_ooo::sampleCounters(unsigned cycles){
+   for(int i = 0; i < EX_TOTAL; i++){
+      unsigned busy       = 0;
+      for(int j = 0; j < execFp[i].numLanes; j++)
+         busy            += execFp[i].lanes[j].busy;
+      counters.busyLanes[i]          += (uint64_t)busy * cycles;
+   }
+   counters.robOccupancy             += (uint64_t)rob.getCount() * cycles;
+   for(int i = 0; i < RS_TOTAL; i++)
+      counters.resStOccupancy[i]     += (uint64_t)resStation[i].count * cycles;
+}
+
+// Applies the effect of "skip" idle cycles at once
+// (lane events are timed in absolute cycles and need no adjustment)
+void sim_ooo::skipCycles(unsigned skip){
+   robT* head             = rob.peekHead();
+   if( head->ready && head->dInstP->is_store && !execFp[MEMORY].lanes[0].busy )
+      head->memLatency     -= skip;
+
+   // Dispatch and commit are held back throughout, for the same reasons
+   counters.dispatchStalled(dispatchHeld(), skip);
+   counters.commitStalls[head->ready ? STALL_STORE_MEMORY : STALL_NOT_READY] += skip;
+   sampleCounters(skip);
+
+   // Fetch is blocked throughout, on the same structure
+   if( rob.isFull() )
+      counters.issueStalls[STALL_ROB]             += skip;
+   else{
+      const microOpT& uop = fetchMicroOp( PC );
+      if( uop.inst.opcode != EOP )
+         counters.issueStalls[resStation[uop.station].isFull() ? STALL_RS : STALL_LSQ] += skip;
+   }
+
+   cycleCount            += skip;
+   skippedCycles         += skip;
+}
 //---------------------------------------------------------------------------------------------------------//
 
 void sim_ooo::run(unsigned cycles){
-   bool rtc    = (cycles == 0);
+   if( cycles == 0 && samplePeriod > 0 )
+      runSampled();
+   else{
+      bool rtc    = (cycles == 0);
+      bool status = true;
+      while((rtc && status) || cycles) {
+         // A bounded run still has to step its last cycle
+         unsigned elapsed;
+         status    = step(rtc ? UNDEFINED : cycles - 1, elapsed);
+         cycles    = cycles > elapsed ? cycles - elapsed : 0;
+      }
+   }
+
+   // Log and trace files are complete up to here once run() returns
+   if( logSink.isOpen() )
+      logSink.flush();
+   if( trace.isOpen() )
+      trace.flush();
+}
+
+// Simulates one clock cycle, after skipping at most maxSkip idle cycles
+// "elapsed" returns the number of cycles consumed; the result is false once
+// the pipeline has nothing left to do
+bool sim_ooo::step(unsigned maxSkip, unsigned& elapsed){
    bool status = true;
-   while((rtc && status) || cycles) {
-      // For feedback FF
-      int popCount;
-      vector<res_station_t> resGCUnit;
-      vector<int>           resGCIndex;
-
-      status    = commit(popCount);
-      status   |= writeResult(resGCUnit, resGCIndex);
-      status   |= execute();
-      status   |= issue();
-
-      if( !gSquash ){
-         int *delElems = (int*) calloc(RS_TOTAL, sizeof(int));
-         for( unsigned i = 0; i < resGCUnit.size(); i++ ){
-            res_station_t unit = resGCUnit[i];
-            resStation[unit].erase( resStation[unit].begin() + resGCIndex[i] - delElems[unit] );
-            delElems[unit]++;
-         }
+   elapsed     = 1;
+   if( cycleSkipping ){
+      unsigned skip = min( idleCycles(), maxSkip );
+      if( skip > 0 ){
+         skipCycles(skip);
+         elapsed   += skip;
+      }
+   }
 
-         for( int i = 0; i < popCount; i++ ){
-            bool underflow;
-            robT robEntry  = rob.pop(underflow);
-            instStatT stat;
-            stat.pc        = robEntry.dInstP->pc;
-            stat.t_issue   = robEntry.dInstP->stat.t_issue;
-            stat.t_execute = robEntry.dInstP->stat.t_execute;
-            stat.t_wr      = robEntry.dInstP->stat.t_wr;
-            stat.t_commit  = robEntry.dInstP->stat.t_commit;
-            log.push_back(stat);
-            ASSERT(!underflow, "ROB underflown");
-         }
+   // For feedback FF
+   int popCount;
+   resGCUnit.clear();
+   resGCIndex.clear();
+
+   status    = commit(popCount);
+   status   |= writeResult(resGCUnit, resGCIndex);
+   status   |= execute();
+   status   |= issue();
+
+   // Instructions retired ahead of a mispredicted branch leave before the squash
+   for( int i = 0; i < popCount; i++ ){
+      bool underflow;
+      robT robEntry  = rob.pop(underflow);
+      logInstruction(robEntry.dInstP);
+      traceRetire(robEntry.dInstP, false);
+      ASSERT(!underflow, "ROB underflown");
+      if( robEntry.lsqIndex != -1 )
+         lsq.pop();
+      dInstPool.release(robEntry.dInstP);
+   }
 
+   if( !gSquash ){
+      for( unsigned i = 0; i < resGCUnit.size(); i++ ){
+         resStation[resGCUnit[i]].release( resGCIndex[i] );
       }
-      else{
-         squash(); 
-         status   = true;
+      // A load fetched again squashes the branch too if it is older
+      if( replayTag != UNDEFINED && (recoverTag == UNDEFINED || robDistance(replayTag) < robDistance(recoverTag)) ){
+         replayLoad(replayTag);
+         status        = true;
+      }
+      else if( recoverTag != UNDEFINED ){
+         recoverBranch(recoverTag);
+         status        = true;
+      }
+   }
+   else{
+      squash(); 
+      status   = true;
+   }
+   recoverTag    = UNDEFINED;
+   replayTag     = UNDEFINED;
+
+   sampleCounters(1);
+   cycleCount++;
+   gSquash       = false;
+   return status;
+}
+
+// Runs in detail until "instructions" more instructions have committed
+// Returns false if the program ended first
+bool sim_ooo::runInstructions(unsigned instructions){
+   unsigned target = instCount + instructions;
+   bool status     = true;
+   while( status && (unsigned)instCount < target ){
+      unsigned elapsed;
+      status       = step(UNDEFINED, elapsed);
+   }
+   return status;
+}
+
+// Sampled run to completion: every period, fast-forward functionally, warm up
+// in detail, then measure one detailed interval
+void sim_ooo::runSampled(){
+   unsigned skip   = samplePeriod - sampleWarmup - sampleInterval;
+   while( true ){
+      if( skip > 0 && fast_forward(skip) < skip )
+         break;
+      if( !runInstructions(sampleWarmup) )
+         break;
+
+      unsigned startInst   = instCount;
+      unsigned startCycle  = cycleCount;
+      bool status          = runInstructions(sampleInterval);
+
+      // Only complete intervals are sampled
+      unsigned insts       = instCount - startInst;
+      unsigned cycles      = cycleCount - startCycle;
+      if( insts >= sampleInterval && cycles > 0 ){
+         // Running mean and sum of squared deviations (Welford)
+         double ipc        = (double)insts / cycles;
+         double delta      = ipc - sampleIPCMean;
+         sampleCount++;
+         sampleIPCMean    += delta / sampleCount;
+         sampleIPCM2      += delta * (ipc - sampleIPCMean);
+      }
+      if( !status )
+         break;
+   }
+}
+
+unsigned sim_ooo::fast_forward(unsigned instructions){
+   // Restart from the oldest instruction that has not committed
+   if( !rob.isEmpty() )
+      PC                 = rob.peekHead()->dInstP->pc;
+   flushPipeline(false);
+   memBlock              = false;
+
+   unsigned executed     = 0;
+   for( ; executed < instructions; executed++ ){
+      int index          = (PC - baseAddress)/4;
+      ASSERT((index >= 0) && (index < instMemSize), "out of bound access of instruction memory %d", index);
+      const microOpT& uop = uops[index];
+      const instructT* instP = &uop.inst;
+      if( instP->opcode == EOP )
+         break;
+
+      unsigned src1V     = instP->src1Valid ? regRead(instP->src1, instP->src1F) : UNDEFINED;
+      unsigned src2V     = instP->src2Valid ? regRead(instP->src2, instP->src2F) : UNDEFINED;
+      // Same address generation as agen(): loads index off src1, stores off src2
+      uint32_t addr      = instP->imm + (int)(instP->is_store ? src2V : src1V);
+      bool taken;
+      uint32_t output    = uop.execute(this, instP, src1V, src2V, addr, taken);
+
+      if( instP->is_store )
+         write_memory(addr, output);
+
+      if( instP->dstValid ){
+         if( instP->dstF )
+            fpFile[instP->dst].value  = unsigned2float(output);
+         else
+            gprFile[instP->dst].value = output;
       }
 
-      cycles = cycles > 0 ? cycles - 1 : 0;
-      cycleCount++;
-      gSquash       = false;
+      // Branches produce the next PC, taken or not, and warm up the predictor
+      if( instP->is_branch ){
+         branchPredT pred;
+         predictBranch(*instP, pred);
+         trainBranch(instP, pred, taken, output);
+         predictor.recover();
+      }
+      PC                 = instP->is_branch ? output : PC + 4;
    }
+   functionalCount      += executed;
+   return executed;
 }
 
 //reset the state of the sim_oooulator
 void sim_ooo::reset(){
-   for(unsigned i = 0; i < data_memory_size; i++) {
-      data_memory[i]   = (unsigned char)UNDEFINED; 
-   }
+   data_memory.clear();
 
    //initializing GPRs to UNDEFINED
    for(int i = 0; i < NUM_GP_REGISTERS; i++) {
@@ -659,33 +1198,157 @@ void sim_ooo::reset(){
 }
 
 void sim_ooo::squash(){
+   PC                = rob.peekHead()->value;
+   flushPipeline(true);
+}
+
+// Position of a ROB entry from the head (0: oldest)
+unsigned sim_ooo::robDistance(unsigned tag){
+   return rob.getCountHeadTail( rob.getHeadIndex(), tag );
+}
+
+// Removes the instructions after the "keep" oldest ones from the pipeline
+void sim_ooo::squashYounger(unsigned keep){
+   // Stations of squashed instructions leave the ready lists, the lanes and their pools
+   for(int i = 0; i < EX_TOTAL; i++){
+      resStationT* next;
+      for(resStationT* resP = readyList[i].head; resP != NULL; resP = next){
+         next             = resP->readyNext;
+         if( robDistance(resP->tagD) >= keep )
+            readyList[i].remove(resP);
+      }
+      for(int j = 0; j < execFp[i].numLanes; j++){
+         execWrLaneT* laneP = &execFp[i].lanes[j];
+         if( laneP->busy && robDistance(laneP->payloadP->tagD) >= keep ){
+            laneP->busy   = false;
+            laneWheel.cancel( (exe_unit_t)i, j );
+         }
+      }
+   }
+   unsigned bypassKeep    = 0;
+   for(unsigned i = 0; i < bypassLane.size(); i++){
+      if( robDistance(bypassLane[i].payloadP->tagD) < keep )
+         bypassLane[bypassKeep++] = bypassLane[i];
+   }
+   bypassLane.resize( bypassKeep );
+   for(int unit = 0; unit < RS_TOTAL; unit++){
+      resStPoolT* poolP   = &resStation[unit];
+      int next;
+      for(int id = poolP->head; id != -1; id = next){
+         next             = poolP->ageNext[id];
+         if( robDistance(poolP->slots[id].tagD) >= keep )
+            poolP->release(id);
+      }
+   }
+
+   // Consumers register youngest first, so squashed ones are at the front of the lists
+   for(unsigned i = 0; i < keep; i++){
+      robT* robP          = rob.peekNth(i);
+      while( robP->jConsumers != NULL && robDistance(robP->jConsumers->tagD) >= keep )
+         robP->jConsumers = robP->jConsumers->jNext;
+      while( robP->kConsumers != NULL && robDistance(robP->kConsumers->tagD) >= keep )
+         robP->kConsumers = robP->kConsumers->kNext;
+   }
+
+   // Squashed instructions go to the execution history as they leave
+   unsigned count         = rob.getCount();
+   for(unsigned i = keep; i < count; i++){
+      robT* robP          = rob.peekNth(i);
+      logInstruction(robP->dInstP);
+      traceRetire(robP->dInstP, true);
+      dInstPool.release(robP->dInstP);
+      if( robP->lsqIndex != -1 )
+         lsq.popTail();
+   }
+   if( keep < count )
+      rob.moveTail( rob.genIndex(keep) );
+}
+
+// Early recovery from a mispredicted branch that wrote its result: the
+// instructions after it leave the pipeline, the rename map goes back to the
+// checkpoint fetch took at the branch and fetch resumes on the right path
+void sim_ooo::recoverBranch(unsigned branchTag){
+   unsigned keep          = robDistance(branchTag) + 1;
+   squashYounger(keep);
+
+   // Tags of instructions that committed since the checkpoint are not pending any more
+   const renameCkptT& ckpt = renameCkpts[branchTag];
+   for(int i = 0; i < NUM_GP_REGISTERS; i++){
+      gprFile[i].tag      = ckpt.gprTag[i];
+      gprFile[i].busy     = ckpt.gprBusy[i] && robDistance(ckpt.gprTag[i]) < keep;
+   }
+   for(int i = 0; i < NUM_FP_REGISTERS; i++){
+      fpFile[i].tag       = ckpt.fpTag[i];
+      fpFile[i].busy      = ckpt.fpBusy[i] && robDistance(ckpt.fpTag[i]) < keep;
+   }
+
+   robT* branchP          = rob.peekIndex(branchTag);
+   predictor.repair( branchP->dInstP->pred, branchP->dInstP->is_taken, branchP->dInstP->opcode != JUMP );
+   PC                     = branchP->value;
+   earlyRecoveries++;
+}
+
+// A load that read a location an older store then turned out to write leaves the
+// pipeline with everything after it, and fetch starts again from the load. The
+// rename map is rebuilt from the instructions left in the ROB
+void sim_ooo::replayLoad(unsigned loadTag){
+   dynInstructPT loadP    = rob.peekIndex(loadTag)->dInstP;
+   unsigned pc            = loadP->pc;
+   uint64_t history       = loadP->pred.history;
+   squashYounger( robDistance(loadTag) );
+
+   for(int i = 0; i < NUM_GP_REGISTERS; i++)
+      gprFile[i].busy     = false;
+   for(int i = 0; i < NUM_FP_REGISTERS; i++)
+      fpFile[i].busy      = false;
+   for(int i = 0; i < rob.getCount(); i++){
+      dynInstructPT dInstP = rob.peekNth(i)->dInstP;
+      if( !dInstP->dstValid )
+         continue;
+      if( dInstP->dstF )
+         set_fp_reg_tag(dInstP->dst, rob.genIndex(i), true);
+      else
+         set_int_reg_tag(dInstP->dst, rob.genIndex(i), true);
+   }
+
+   predictor.history      = history;
+   PC                     = pc;
+   loadReplays++;
+}
+
+// Empties every in-flight structure, optionally recording the flushed
+// instructions in the execution history
+void sim_ooo::flushPipeline(bool record){
    //flushing EXEC UNITS
    for(int i = 0; i < EX_TOTAL; i++){
       for(int j = 0; j < execFp[i].numLanes; j++){
-         execFp[i].lanes[j].ttl = 0;
+         execFp[i].lanes[j].busy = false;
       }
    }
+   laneWheel.clear();
+   bypassLane.clear();
    //Clearing Res Station
    for(int i = 0; i < RS_TOTAL; i++){
       resStation[i].clear();
    }
+   for(int i = 0; i < EX_TOTAL; i++){
+      readyList[i].clear();
+   }
 
-   PC                = rob.peekHead()->value;
    //Clearing ROB and recording history
    int popCount      = rob.getCount();
    for( int i = 0; i < popCount; i++ ){
       bool underflow;
       robT robEntry  = rob.pop(underflow);
-      instStatT stat;
-      stat.pc        = robEntry.dInstP->pc;
-      stat.t_issue   = robEntry.dInstP->stat.t_issue;
-      stat.t_execute = robEntry.dInstP->stat.t_execute;
-      stat.t_wr      = robEntry.dInstP->stat.t_wr;
-      stat.t_commit  = robEntry.dInstP->stat.t_commit;
-      log.push_back(stat);
+      if( record )
+         logInstruction(robEntry.dInstP);
+      // Only the mispredicted branch at the head got to commit
+      traceRetire(robEntry.dInstP, !record || robEntry.dInstP->stat.state != COMMIT);
       ASSERT(!underflow, "ROB underflown");
+      dInstPool.release(robEntry.dInstP);
    }
    rob.popAll();
+   lsq.clear();
 
    // Flash clear busy bits
    for(int i = 0; i < NUM_FP_REGISTERS; i++) {
@@ -695,6 +1358,10 @@ void sim_ooo::squash(){
    for(int i = 0; i < NUM_GP_REGISTERS; i++) {
       gprFile[i].busy = false;
    }
+
+   // Fetch restarts from the history of the retired branches
+   predictor.recover();
+   storeSets.flush();
 }
 
 //--------------------------------------- IMPORTANT FUNCTIONS ---------------------------------------------//
@@ -739,14 +1406,9 @@ exe_unit_t sim_ooo::opcodeToExUnit(opcode_t opcode){
          unit = INTEGER;
          break;
    }
-   ASSERT( execFp[unit].numLanes > 0, "No lanes found for opcode: %s", opcode_str[opcode].c_str());
    return unit;
 }
 
-int sim_ooo::exLatency(opcode_t opcode) {
-   return execFp[opcodeToExUnit(opcode)].latency;
-}
-
 uint32_t sim_ooo::agen ( resStationT* resP ) {
    uint32_t stAddr  = resP->dInstP->imm + (int) resP->vk;
    uint32_t ldAddr  = resP->dInstP->imm + (int) resP->vj;
@@ -908,17 +1570,29 @@ unsigned sim_ooo::get_pending_fp_register(unsigned reg){
 //-------------------------------------------------------------------------------------------------------//
 
 void sim_ooo::print_status(){
-	print_pending_instructions();
-	print_rob();
-	print_reservation_stations();
-	print_registers();
+   if( fastPrint && text.begin(cout) ){
+      renderPendingInstructions();
+      renderRob();
+      renderReservationStations();
+      renderRegisters();
+      text.end(cout);
+      return;
+   }
+	streamPendingInstructions();
+	streamRob();
+	streamReservationStations();
+	streamRegisters();
+}
+
+void sim_ooo::set_fast_print(bool enable){
+   fastPrint              = enable;
 }
 
 void sim_ooo::print_memory(unsigned start_address, unsigned end_address){
 	cout << "DATA MEMORY[0x" << hex << setw(8) << setfill('0') << start_address << ":0x" << hex << setw(8) << setfill('0') <<  end_address << "]" << endl;
 	for (unsigned i=start_address; i<end_address; i++){
 		if (i%4 == 0) cout << "0x" << hex << setw(8) << setfill('0') << i << ": "; 
-		cout << hex << setw(2) << setfill('0') << int(data_memory[i]) << " ";
+		cout << hex << setw(2) << setfill('0') << int(data_memory.readByte(i)) << " ";
 		if (i%4 == 3){
 			cout << endl;
 		}
@@ -930,18 +1604,58 @@ void sim_ooo::print_memory(unsigned start_address, unsigned end_address){
 void sim_ooo::write_memory(unsigned address, unsigned value){
    ASSERT( address % 4 == 0, "Unaligned memory access found at address %x", address ); 
    ASSERT ( (address >= 0) && (address < data_memory_size), "Out of bounds memory accessed: Seg Fault!!!!" );
-	unsigned2char(value,data_memory+address);
+	unsigned2char(value,data_memory.writeWord(address));
 }
 
 unsigned sim_ooo::read_memory(unsigned address){
    ASSERT( address % 4 == 0, "Unaligned memory access found at address %x", address ); 
    ASSERT ( (address >= 0) && (address < data_memory_size), "Out of bounds memory accessed: Seg Fault!!!!" );
-   return char2unsigned(data_memory+address);
+   return char2unsigned(data_memory.readWord(address));
+}
+
+void sim_ooo::load_data_image(const char *filename, unsigned base_address){
+   int fd                   = open( filename, O_RDONLY );
+   ASSERT( fd >= 0, "Unable to open file: %s", filename );
+   struct stat info;
+   ASSERT( fstat( fd, &info ) == 0, "Unable to read file size: %s", filename );
+   ASSERT( base_address <= data_memory_size && (uint64_t)info.st_size <= data_memory_size - base_address,
+           "Data image %s (%llu bytes) does not fit in memory at address %x", filename, (unsigned long long)info.st_size, base_address );
+   if( info.st_size == 0 ){
+      close( fd );
+      return;
+   }
+
+   void *image              = mmap( NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+   close( fd );
+   ASSERT( image != MAP_FAILED, "Unable to map file: %s", filename );
+   if( base_address % MEM_PAGE_SIZE == 0 )
+      data_memory.map( base_address, image, info.st_size );
+   else{
+      data_memory.writeBytes( base_address, (unsigned char*)image, info.st_size );
+      munmap( image, info.st_size );
+   }
+}
+
+void sim_ooo::dump_memory_image(const char *filename, unsigned start_address, unsigned end_address){
+   ASSERT( start_address <= end_address && end_address <= data_memory_size, "Bad memory range [%x, %x)", start_address, end_address );
+   ofstream out( filename, ofstream::out | ofstream::trunc | ofstream::binary );
+   ASSERT( out.is_open(), "Unable to open file: %s", filename );
+
+   unsigned char untouched[MEM_PAGE_SIZE];
+   memset( untouched, 0xFF, MEM_PAGE_SIZE );
+   for(unsigned address = start_address; address < end_address; ){
+      unsigned offset       = address & (MEM_PAGE_SIZE - 1);
+      unsigned n            = min( end_address - address, MEM_PAGE_SIZE - offset );
+      memPageT *page        = data_memory.peek( address );
+      out.write( (const char*)(page == NULL ? untouched : page->bytes + offset), n );
+      address              += n;
+   }
+   ASSERT( out.good(), "Unable to write file: %s", filename );
 }
 //---------------------------READ AND WRITE MEMORY FUNCTIONS END----------------------------------------//
 
 //------------------------------------------------------------------------------------------------------//
-void sim_ooo::print_registers(){
+void sim_ooo::streamRegisters(){
         unsigned i;
 	cout << "GENERAL PURPOSE REGISTERS" << endl;
 	cout << setfill(' ') << setw(8) << "Register" << setw(22) << "Value" << setw(5) << "ROB" << endl;
@@ -960,7 +1674,7 @@ void sim_ooo::print_registers(){
 	cout << endl;
 }
 
-void sim_ooo::print_rob(){
+void sim_ooo::streamRob(){
    unsigned i;
 	cout << "REORDER BUFFER" << endl; 
 	cout << setfill(' ') << setw(5) << "Entry" << setw(6) << "Busy" << setw(7) << "Ready" << setw(12) << "PC" << setw(10) << "State" << setw(6) << "Dest" << setw(12) << "Value" << endl;
@@ -1004,23 +1718,19 @@ void sim_ooo::print_rob(){
 	cout << endl;
 }
 
-void sim_ooo::print_reservation_stations(){
+void sim_ooo::streamReservationStations(){
 	cout << "RESERVATION STATIONS" << endl;
 	cout  << setfill(' ');
 	cout << setw(7) << "Name" << setw(6) << "Busy" << setw(12) << "PC" << setw(12) << "Vj" << setw(12) << "Vk" << setw(6) << "Qj" << setw(6) << "Qk" << setw(6) << "Dest" << setw(12) << "Address" << endl; 
 	
    for( int unit = 0; unit < RS_TOTAL; unit++ ){
-      uint32_t id = 0;
-      vector<resStationT*> resSt = resStation[unit];
-      sort(resSt.begin(), resSt.end(), resStSort);
-
-      for( int i = 0; i < (int)resSt.size(); i++ ){
-         resStationT* resP  = resSt[i];
-         for( int j = id; j < resSt[i]->id; j++ ){
-            cout << setw(7) << res_station_names[unit] << j+1 << setw(6) << "no" << setw(12) << "-" << setw(12) << "-" << setw(12) << "-" << setw(6) << "-" << setw(6) << "-" << setw(6) << "-" << setw(12) << "-" << endl; 
+      for( unsigned id = 0; id < resStSize[unit]; id++ ){
+         if( resStation[unit].isFree(id) ){
+            cout << setw(7) << res_station_names[unit] << id+1 << setw(6) << "no" << setw(12) << "-" << setw(12) << "-" << setw(12) << "-" << setw(6) << "-" << setw(6) << "-" << setw(6) << "-" << setw(12) << "-" << endl; 
+            continue;
          }
-         id = resSt[i]->id + 1;
-         cout << setw(7) << res_station_names[unit] << id << setw(6) << "yes";
+         resStationT* resP  = &resStation[unit].slots[id];
+         cout << setw(7) << res_station_names[unit] << id+1 << setw(6) << "yes";
          cout << setw(4) << "0x" << setw(8) << setfill('0') << hex << resP->dInstP->pc << setfill(' ');
 
          if( resP->vj == UNDEFINED )
@@ -1053,15 +1763,12 @@ void sim_ooo::print_reservation_stations(){
 
          cout << endl;
       }
-      for( unsigned i = id; i < resStSize[unit]; i++ ){
-         cout << setw(7) << res_station_names[unit] << i+1 << setw(6) << "no" << setw(12) << "-" << setw(12) << "-" << setw(12) << "-" << setw(6) << "-" << setw(6) << "-" << setw(6) << "-" << setw(12) << "-" << endl; 
-      }
    }
 
 	cout << endl;
 }
 
-void sim_ooo::print_pending_instructions(){
+void sim_ooo::streamPendingInstructions(){
 	cout << "PENDING INSTRUCTIONS STATUS" << endl;
 	cout << setfill(' ');
 	cout << setw(10) << "PC" << setw(7) << "Issue" << setw(7) << "Exe" << setw(7) << "WR" << setw(7) << "Commit" << endl;
@@ -1093,38 +1800,213 @@ void sim_ooo::print_pending_instructions(){
 	cout << endl;
 }
 
-//-------------------------------------------------------------------------------------------------------------------------------------------//
-void sim_ooo::print_log(){
-   cout << "EXECUTION LOG" << endl;
-   cout << setw(12) << setfill(' ') << "PC" << setw(7) << "Issue" << setw(7) << "Exe" << setw(7) << "WR" << setw(7) << "Commit" << endl;
-   for( unsigned i = 0; i < log.size(); i++ ){
-      cout << "0x" << setw(8) << hex << setfill('0') << log[i].pc << setw(7) << setfill(' ');
-      if( log[i].t_issue == UNDEFINED )
-         cout << "-";
-      else
-         cout << dec << log[i].t_issue;
-      
-      cout << setw(7);
-      
-      if( log[i].t_execute == UNDEFINED )
-         cout << "-";
-      else
-         cout << log[i].t_execute;
-      
-      cout << setw(7);
-      if( log[i].t_wr == UNDEFINED )
-         cout << "-";
+//---------------------------------------- Buffered renderers ----------------------------------------------//
+// Same output as the stream* functions above, field for field
+
+void sim_ooo::print_registers(){
+   if( fastPrint && text.begin(cout) ){
+      renderRegisters();
+      text.end(cout);
+   }
+   else
+      streamRegisters();
+}
+
+void sim_ooo::print_rob(){
+   if( fastPrint && text.begin(cout) ){
+      renderRob();
+      text.end(cout);
+   }
+   else
+      streamRob();
+}
+
+void sim_ooo::print_reservation_stations(){
+   if( fastPrint && text.begin(cout) ){
+      renderReservationStations();
+      text.end(cout);
+   }
+   else
+      streamReservationStations();
+}
+
+void sim_ooo::print_pending_instructions(){
+   if( fastPrint && text.begin(cout) ){
+      renderPendingInstructions();
+      text.end(cout);
+   }
+   else
+      streamPendingInstructions();
+}
+
+void sim_ooo::renderRegisters(){
+   text.put("GENERAL PURPOSE REGISTERS").endl();
+   text.setfill(' ').setw(8).put("Register").setw(22).put("Value").setw(5).put("ROB").endl();
+   for(unsigned i = 0; i < NUM_GP_REGISTERS; i++){
+      if( get_pending_int_register(i) != UNDEFINED )
+         text.setfill(' ').setw(7).put("R").dec().put(i).setw(22).put("-").setw(5).put(get_pending_int_register(i)).endl();
+      else if( get_int_register(i) != (int)UNDEFINED )
+         text.setfill(' ').setw(7).put("R").dec().put(i).setw(11).put(get_int_register(i)).hex().put("/0x").setw(8).setfill('0').put(get_int_register(i)).setfill(' ').setw(5).put("-").endl();
+   }
+   for(unsigned i = 0; i < NUM_FP_REGISTERS; i++){
+      if( get_pending_fp_register(i) != UNDEFINED )
+         text.setfill(' ').setw(7).put("F").dec().put(i).setw(22).put("-").setw(5).put(get_pending_fp_register(i)).endl();
+      else if( get_fp_register(i) != UNDEFINED )
+         text.setfill(' ').setw(7).put("F").dec().put(i).setw(11).put(get_fp_register(i)).hex().put("/0x").setw(8).setfill('0').put(float2unsigned(get_fp_register(i))).setfill(' ').setw(5).put("-").endl();
+   }
+   text.endl();
+}
+
+void sim_ooo::renderRob(){
+   text.put("REORDER BUFFER").endl();
+   text.setfill(' ').setw(5).put("Entry").setw(6).put("Busy").setw(7).put("Ready").setw(12).put("PC").setw(10).put("State").setw(6).put("Dest").setw(12).put("Value").endl();
+   for(unsigned i = 0; i < robSize; i++){
+      if( !rob.isBusy(i) ){
+         text.setfill(' ').setw(5).put(i).setw(6).put("no").setw(7).put("no").setw(12).put("-").setw(10).put("-").setw(6).put("-").setw(12).put("-").endl();
+         continue;
+      }
+      robT* robP           = rob.peekIndex(i);
+      dynInstructPT dInstP = robP->dInstP;
+      text.setfill(' ').setw(5).put(i).setw(6).put("yes").setw(7).put(robP->ready ? "yes" : "no").setw(4).put("0x").setw(8).setfill('0').hex().put(dInstP->pc).setw(10).setfill(' ').put(stage_names[dInstP->stat.state]).setw(5);
+
+      if( dInstP->dstValid )
+         text.put(dInstP->dstF ? "F" : "R").put(dInstP->dst);
+      else if( dInstP->is_store ){
+         if( robP->dest == UNDEFINED || dInstP->stat.state < EXECUTE )
+            text.put("-");
+         else
+            text.setw(8).dec().put(robP->dest).setfill(' ');
+      }
       else
-         cout << log[i].t_wr;
-      
-      cout << setw(7);
-      if( log[i].t_commit == UNDEFINED )
-         cout << "-";
+         text.put("-");
+
+      text.setw(12);
+      if( robP->value == UNDEFINED )
+         text.put("-");
       else
-         cout << log[i].t_commit;
-      
-      cout << endl;
+         text.setw(5).setfill(' ').put("0x").setw(8).setfill('0').hex().put(robP->value);
+      text.endl();
    }
+   text.endl();
+}
+
+void sim_ooo::renderReservationStations(){
+   text.put("RESERVATION STATIONS").endl();
+   text.setfill(' ');
+   text.setw(7).put("Name").setw(6).put("Busy").setw(12).put("PC").setw(12).put("Vj").setw(12).put("Vk").setw(6).put("Qj").setw(6).put("Qk").setw(6).put("Dest").setw(12).put("Address").endl();
+
+   for( int unit = 0; unit < RS_TOTAL; unit++ ){
+      for( unsigned id = 0; id < resStSize[unit]; id++ ){
+         if( resStation[unit].isFree(id) ){
+            text.setw(7).put(res_station_names[unit]).put(id+1).setw(6).put("no").setw(12).put("-").setw(12).put("-").setw(12).put("-").setw(6).put("-").setw(6).put("-").setw(6).put("-").setw(12).put("-").endl();
+            continue;
+         }
+         resStationT* resP  = &resStation[unit].slots[id];
+         text.setw(7).put(res_station_names[unit]).put(id+1).setw(6).put("yes");
+         text.setw(4).put("0x").setw(8).setfill('0').hex().put(resP->dInstP->pc).setfill(' ');
+
+         if( resP->vj == UNDEFINED )
+            text.setw(12).put("-");
+         else
+            text.setw(4).setfill(' ').put("0x").setw(8).setfill('0').hex().put(resP->vj).setfill(' ');
+
+         if( resP->vk == UNDEFINED )
+            text.setw(12).put("-");
+         else
+            text.setw(4).setfill(' ').put("0x").setw(8).setfill('0').hex().put(resP->vk).setfill(' ');
+
+         if( resP->qj == UNDEFINED )
+            text.setw(6).put("-");
+         else
+            text.setw(6).hex().put(resP->qj).setfill(' ');
+
+         if( resP->qk == UNDEFINED )
+            text.setw(6).put("-");
+         else
+            text.setw(6).hex().put(resP->qk).setfill(' ');
+
+         text.setw(6).put(resP->tagD);
+
+         if( resP->addr == UNDEFINED )
+            text.setw(12).put("-");
+         else
+            text.setw(4).setfill(' ').put("0x").setw(8).setfill('0').hex().put(resP->addr).setfill(' ');
+
+         text.endl();
+      }
+   }
+   text.endl();
+}
+
+void sim_ooo::renderPendingInstructions(){
+   text.put("PENDING INSTRUCTIONS STATUS").endl();
+   text.setfill(' ');
+   text.setw(10).put("PC").setw(7).put("Issue").setw(7).put("Exe").setw(7).put("WR").setw(7).put("Commit").endl();
+   for(unsigned i = 0; i < robSize; i++){
+      if( !rob.isBusy(i) ){
+         text.setw(10).put("-").setw(7).put("-").setw(7).put("-").setw(7).put("-").setw(7).put("-").endl();
+         continue;
+      }
+      dynInstructPT dP     = rob.peekIndex(i)->dInstP;
+      text.put("0x").setw(8).setfill('0').hex().put(dP->pc).setfill(' ');
+      unsigned stamps[4]   = { dP->stat.t_issue, dP->stat.t_execute, dP->stat.t_wr, dP->stat.t_commit };
+      for(int s = 0; s < 4; s++){
+         if( stamps[s] == UNDEFINED ) text.setw(7).put("-");
+         else                         text.setw(7).dec().put(stamps[s]);
+      }
+      text.endl();
+   }
+   text.endl();
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------//
+static void printLogHeader(){
+   cout << "EXECUTION LOG" << endl;
+   cout << setw(12) << setfill(' ') << "PC" << setw(7) << "Issue" << setw(7) << "Exe" << setw(7) << "WR" << setw(7) << "Commit" << endl;
+}
+
+static void printLogRecord(const instStatT& stat){
+   cout << "0x" << setw(8) << hex << setfill('0') << stat.pc << setw(7) << setfill(' ');
+   if( stat.t_issue == UNDEFINED )
+      cout << "-";
+   else
+      cout << dec << stat.t_issue;
+   
+   cout << setw(7);
+   
+   if( stat.t_execute == UNDEFINED )
+      cout << "-";
+   else
+      cout << stat.t_execute;
+   
+   cout << setw(7);
+   if( stat.t_wr == UNDEFINED )
+      cout << "-";
+   else
+      cout << stat.t_wr;
+   
+   cout << setw(7);
+   if( stat.t_commit == UNDEFINED )
+      cout << "-";
+   else
+      cout << stat.t_commit;
+   
+   cout << endl;
+}
+
+void sim_ooo::print_log(){
+   printLogHeader();
+   for( unsigned i = 0; i < log.size(); i++ )
+      printLogRecord(log[i]);
+}
+
+void print_log_file(const char *filename){
+   logReaderT reader;
+   reader.open(filename);
+   printLogHeader();
+   instStatT stat;
+   while( reader.next(stat) )
+      printLogRecord(stat);
 }
 
 float sim_ooo::get_IPC(){
@@ -1139,6 +2021,720 @@ unsigned sim_ooo::get_clock_cycles(){
    return cycleCount - 1; 
 }
 
+void sim_ooo::reserve_log(unsigned entries){
+   log.reserve( entries );
+}
+
+void sim_ooo::set_log_file(const char *filename){
+   if( filename == NULL )
+      logSink.close();
+   else
+      logSink.open( filename );
+}
+
+void sim_ooo::set_log_memory(bool enable){
+   logMemory              = enable;
+}
+
+void sim_ooo::set_trace_file(const char *filename){
+   // Instructions already in flight are left out of the new file
+   for(unsigned i = 0; i < dInstPool.size; i++)
+      dInstPool.entries[i].traceId = UNDEFINED;
+
+   if( filename == NULL )
+      trace.close();
+   else
+      trace.open( filename, cycleCount );
+}
+
+// Records a stage transition in the pipeline trace
+void sim_ooo::traceStage(dynInstructPT dInstP, stage_t stage){
+   if( trace.isOpen() && dInstP->traceId != UNDEFINED )
+      trace.stage( dInstP->traceId, stage, cycleCount );
+}
+
+// Records an instruction leaving the pipeline in the pipeline trace
+void sim_ooo::traceRetire(dynInstructPT dInstP, bool flushed){
+   if( trace.isOpen() && dInstP->traceId != UNDEFINED )
+      trace.retire( dInstP->traceId, flushed, cycleCount );
+}
+
+// Records a committed or squashed instruction in the execution history
+void sim_ooo::logInstruction(dynInstructPT dInstP){
+   instStatT stat;
+   stat.pc                = dInstP->pc;
+   stat.t_issue           = dInstP->stat.t_issue;
+   stat.t_execute         = dInstP->stat.t_execute;
+   stat.t_wr              = dInstP->stat.t_wr;
+   stat.t_commit          = dInstP->stat.t_commit;
+   if( logMemory )
+      log.push_back(stat);
+   if( logSink.isOpen() )
+      logSink.put(stat);
+}
+
+unsigned sim_ooo::get_dyn_inst_pool_live(){
+   return dInstPool.live;
+}
+
+unsigned sim_ooo::get_dyn_inst_pool_peak(){
+   return dInstPool.peak;
+}
+
+unsigned sim_ooo::get_lsq_occupancy(){
+   return lsq.count;
+}
+
+void sim_ooo::set_cycle_skipping(bool enable){
+   cycleSkipping = enable;
+}
+
+unsigned sim_ooo::get_skipped_cycles(){
+   return skippedCycles;
+}
+
+unsigned sim_ooo::get_functional_instructions(){
+   return functionalCount;
+}
+
+unsigned sim_ooo::get_issue_stall_cycles(issue_stall_t reason){
+   ASSERT( reason < STALL_TOTAL, "Unknown issue stall reason (=%d)", reason );
+   return counters.issueStalls[reason];
+}
+
+unsigned sim_ooo::get_dirty_memory_pages(){
+   return data_memory.dirtyPages.size();
+}
+
+unsigned sim_ooo::get_dispatch_stall_cycles(dispatch_stall_t reason){
+   ASSERT( reason < DISPATCH_STALL_TOTAL, "Unknown dispatch stall reason (=%d)", reason );
+   return counters.dispatchStalls[reason];
+}
+
+unsigned sim_ooo::get_commit_stall_cycles(commit_stall_t reason){
+   ASSERT( reason < COMMIT_STALL_TOTAL, "Unknown commit stall reason (=%d)", reason );
+   return counters.commitStalls[reason];
+}
+
+uint64_t sim_ooo::get_busy_lane_cycles(exe_unit_t exec_unit){
+   ASSERT( exec_unit < EX_TOTAL, "Unknown execution unit (=%d)", exec_unit );
+   return counters.busyLanes[exec_unit];
+}
+
+uint64_t sim_ooo::get_rob_occupancy(){
+   return counters.robOccupancy;
+}
+
+uint64_t sim_ooo::get_res_station_occupancy(res_station_t res_station){
+   ASSERT( res_station < RS_TOTAL, "Unknown reservation station type (=%d)", res_station );
+   return counters.resStOccupancy[res_station];
+}
+
+void sim_ooo::print_counters(){
+   static const char *issue_stall_names[STALL_TOTAL] = {"ROB full", "Res. stations full", "LSQ full"};
+   static const char *dispatch_stall_names[DISPATCH_STALL_TOTAL] = {"Lanes busy", "Memory blocked", "Store conflict"};
+   static const char *commit_stall_names[COMMIT_STALL_TOTAL] = {"ROB empty", "Head not ready", "Store to memory"};
+   static const char *exec_unit_names[EX_TOTAL] = {"Integer", "Adder", "Multiplier", "Divider", "Memory"};
+   unsigned clockCycles   = cycleCount > 0 ? get_clock_cycles() : 0;
+   double cycles          = clockCycles > 0 ? clockCycles : 1;
+   ios::fmtflags flags    = cout.flags();
+   streamsize precision   = cout.precision();
+   char fill              = cout.fill();
+
+   cout << "COUNTERS (" << dec << clockCycles << " cycles)" << endl;
+   cout << setfill(' ') << setw(30) << "Stall" << setw(10) << "Cycles" << setw(9) << "%" << endl;
+   cout << fixed << setprecision(2);
+   for(int i = 0; i < STALL_TOTAL; i++)
+      cout << setw(10) << "Issue: " << setw(20) << issue_stall_names[i] << setw(10) << counters.issueStalls[i] << setw(9) << 100 * counters.issueStalls[i] / cycles << endl;
+   for(int i = 0; i < DISPATCH_STALL_TOTAL; i++)
+      cout << setw(10) << "Dispatch: " << setw(20) << dispatch_stall_names[i] << setw(10) << counters.dispatchStalls[i] << setw(9) << 100 * counters.dispatchStalls[i] / cycles << endl;
+   for(int i = 0; i < COMMIT_STALL_TOTAL; i++)
+      cout << setw(10) << "Commit: " << setw(20) << commit_stall_names[i] << setw(10) << counters.commitStalls[i] << setw(9) << 100 * counters.commitStalls[i] / cycles << endl;
+
+   cout << setw(30) << "Unit" << setw(10) << "Lanes" << setw(9) << "Busy %" << endl;
+   for(int i = 0; i < EX_TOTAL; i++){
+      double lanes        = execFp[i].numLanes > 0 ? execFp[i].numLanes : 1;
+      cout << setw(30) << exec_unit_names[i] << setw(10) << execFp[i].numLanes << setw(9) << 100 * counters.busyLanes[i] / (lanes * cycles) << endl;
+   }
+
+   cout << setw(30) << "Structure" << setw(10) << "Size" << setw(9) << "Avg use" << endl;
+   cout << setw(30) << "ROB" << setw(10) << robSize << setw(9) << counters.robOccupancy / cycles << endl;
+   for(int i = 0; i < RS_TOTAL; i++)
+      cout << setw(30) << res_station_names[i] << setw(10) << resStSize[i] << setw(9) << counters.resStOccupancy[i] / cycles << endl;
+   cout.flags( flags );
+   cout.precision( precision );
+   cout.fill( fill );
+}
+
+void sim_ooo::set_branch_predictor(predictor_t type, unsigned index_bits, unsigned btb_entries){
+   ASSERT( type < PREDICTOR_TOTAL, "Unknown branch predictor (=%d)", type );
+   ASSERT( index_bits > 0 && index_bits <= 24, "Branch predictor index bits out of range (=%u)", index_bits );
+   ASSERT( btb_entries > 0 && (btb_entries & (btb_entries - 1)) == 0, "BTB entries must be a power of two (=%u)", btb_entries );
+   ASSERT( rob.isEmpty(), "Branch predictor changed with instructions in flight" );
+   predictor.init(type, index_bits, btb_entries);
+}
+
+void sim_ooo::set_early_recovery(bool enable){
+   ASSERT( rob.isEmpty(), "Early recovery changed with instructions in flight" );
+   earlyRecovery          = enable;
+}
+
+unsigned sim_ooo::get_early_recoveries(){
+   return earlyRecoveries;
+}
+
+void sim_ooo::set_store_sets(bool enable, unsigned ssit_bits, unsigned lfst_entries){
+   ASSERT( ssit_bits > 0 && ssit_bits <= 24, "SSIT index bits out of range (=%u)", ssit_bits );
+   ASSERT( lfst_entries > 0, "Store sets need at least one LFST entry" );
+   ASSERT( rob.isEmpty(), "Store sets changed with instructions in flight" );
+   storeSetsOn            = enable;
+   storeSets.init( ssit_bits, lfst_entries );
+}
+
+unsigned sim_ooo::get_speculative_loads(){
+   return speculativeLoads;
+}
+
+unsigned sim_ooo::get_memory_violations(){
+   return memViolations;
+}
+
+unsigned sim_ooo::get_load_replays(){
+   return loadReplays;
+}
+
+unsigned sim_ooo::get_branches(){
+   unsigned total         = 0;
+   for(unsigned i = 0; i < branchStats.size(); i++)
+      total              += branchStats[i].executed;
+   return total;
+}
+
+unsigned sim_ooo::get_branch_mispredictions(){
+   unsigned total         = 0;
+   for(unsigned i = 0; i < branchStats.size(); i++)
+      total              += branchStats[i].mispredicted;
+   return total;
+}
+
+float sim_ooo::get_branch_accuracy(unsigned pc){
+   unsigned index         = (pc - baseAddress) / 4;
+   ASSERT( index < branchStats.size(), "PC out of the program (=%x)", pc );
+   const branchStatT& stat = branchStats[index];
+   return stat.executed > 0 ? 1 - (float)stat.mispredicted / stat.executed : 1;
+}
+
+void sim_ooo::print_branch_stats(){
+   static const char *predictor_names[PREDICTOR_TOTAL] = {"not-taken", "bimodal", "gshare", "TAGE"};
+   unsigned branches      = get_branches();
+   unsigned mispredicted  = get_branch_mispredictions();
+   ios::fmtflags flags    = cout.flags();
+   streamsize precision   = cout.precision();
+   char fill              = cout.fill();
+
+   cout << "BRANCHES (" << predictor_names[predictor.type] << ", " << dec << branches << " committed, " << mispredicted << " mispredicted)" << endl;
+   cout << setfill(' ') << setw(10) << "PC" << setw(8) << "Opcode" << setw(10) << "Executed" << setw(10) << "Taken" << setw(10) << "Mispred" << setw(11) << "Accuracy %" << endl;
+   cout << fixed << setprecision(2);
+   unsigned taken         = 0;
+   for(unsigned i = 0; i < branchStats.size(); i++){
+      const branchStatT& stat = branchStats[i];
+      if( stat.executed == 0 )
+         continue;
+      taken              += stat.taken;
+      cout << "0x" << hex << setfill('0') << setw(8) << baseAddress + 4*i << dec << setfill(' ')
+           << setw(8) << instr_names[instMemory[i].opcode] << setw(10) << stat.executed << setw(10) << stat.taken
+           << setw(10) << stat.mispredicted << setw(11) << 100 * (1 - (double)stat.mispredicted / stat.executed) << endl;
+   }
+   cout << setw(18) << "Total" << setw(10) << branches << setw(10) << taken << setw(10) << mispredicted << setw(11) << (branches > 0 ? 100 * (1 - (double)mispredicted / branches) : 100.0) << endl;
+   cout.flags( flags );
+   cout.precision( precision );
+   cout.fill( fill );
+}
+
+void sim_ooo::set_sampling(unsigned period, unsigned interval, unsigned warmup){
+   ASSERT( period == 0 || interval > 0, "Sampling needs a non-empty measured interval" );
+   ASSERT( period == 0 || period >= interval + warmup, "Sampling period (=%u) shorter than warm-up + interval", period );
+   samplePeriod     = period;
+   sampleInterval   = interval;
+   sampleWarmup     = warmup;
+   sampleCount      = 0;
+   sampleIPCMean    = 0;
+   sampleIPCM2      = 0;
+}
+
+unsigned sim_ooo::get_samples(){
+   return sampleCount;
+}
+
+float sim_ooo::get_sampled_IPC(){
+   return sampleIPCMean;
+}
+
+float sim_ooo::get_sampled_IPC_error(){
+   if( sampleCount < 2 )
+      return 0;
+   double variance  = sampleIPCM2 / (sampleCount - 1);
+   // 95% confidence, normal approximation
+   return 1.96 * sqrt( variance / sampleCount );
+}
+
+//-------------------------------- CHECKPOINT BEGIN -------------------------------
+// Layout (host byte order):
+//   magic, version, flags (bit 0: microarchitectural state present)
+//   configuration, checked on restore
+//   PC, cycle count, instruction count, stall/utilization counters, per-branch statistics,
+//   memory dependence speculation counts, early recovery count, register files
+//   data memory as a list of chunks that differ from the reset value (0xFF)
+//   [microarchitectural state, pointers stored as slot indices]
+static const char     CKPT_MAGIC[8]  = "OOOCKPT";
+static const uint32_t CKPT_VERSION   = 8;
+static const unsigned CKPT_CHUNK     = 256;
+
+template <typename T> static void ckptPut( ofstream& out, const T& value ){
+   out.write( (const char*)&value, sizeof(T) );
+}
+
+template <typename T> static void ckptGet( ifstream& in, T& value ){
+   in.read( (char*)&value, sizeof(T) );
+   ASSERT( in.good(), "Truncated checkpoint" );
+}
+
+template <typename T> static void ckptCheck( ifstream& in, T expected, const char* what ){
+   T value;
+   ckptGet( in, value );
+   ASSERT( value == expected, "Checkpoint does not match simulator configuration (%s)", what );
+}
+
+// Reservation station pointer <-> (unit << 16 | id), -1 for NULL
+int sim_ooo::stationToCode(resStationT* resP){
+   if( resP == NULL )
+      return -1;
+   for(int unit = 0; unit < RS_TOTAL; unit++){
+      if( resP >= resStation[unit].slots && resP < resStation[unit].slots + resStSize[unit] )
+         return (unit << 16) | (int)(resP - resStation[unit].slots);
+   }
+   ASSERT( false, "Reservation station pointer outside of every pool" );
+   return -1;
+}
+
+resStationT* sim_ooo::codeToStation(int code){
+   if( code == -1 )
+      return NULL;
+   unsigned unit  = code >> 16;
+   unsigned id    = code & 0xFFFF;
+   ASSERT( unit < RS_TOTAL && id < resStSize[unit], "Bad reservation station in checkpoint (=%x)", code );
+   return &resStation[unit].slots[id];
+}
+
+// Dynamic instruction pointer <-> pool index, -1 for NULL
+int sim_ooo::dInstToCode(dynInstructPT dInstP){
+   if( dInstP == NULL )
+      return -1;
+   ASSERT( dInstP >= dInstPool.entries && dInstP < dInstPool.entries + dInstPool.size, "Dynamic instruction pointer outside of pool" );
+   return dInstP - dInstPool.entries;
+}
+
+dynInstructPT sim_ooo::codeToDInst(int code){
+   if( code == -1 )
+      return NULL;
+   ASSERT( code >= 0 && (unsigned)code < dInstPool.size, "Bad dynamic instruction in checkpoint (=%d)", code );
+   return &dInstPool.entries[code];
+}
+
+void sim_ooo::save_checkpoint(const char *filename, bool microarchitectural){
+   ofstream out( filename, ofstream::out | ofstream::binary );
+   ASSERT( out.is_open(), "Unable to open file: %s", filename );
+
+   out.write( CKPT_MAGIC, sizeof(CKPT_MAGIC) );
+   ckptPut( out, CKPT_VERSION );
+   ckptPut( out, (uint32_t)microarchitectural );
+
+   // Configuration
+   ckptPut( out, data_memory_size );
+   ckptPut( out, robSize );
+   for(int i = 0; i < RS_TOTAL; i++)
+      ckptPut( out, resStSize[i] );
+   ckptPut( out, lsq.size );
+   for(int i = 0; i < EX_TOTAL; i++){
+      ckptPut( out, execFp[i].numLanes );
+      ckptPut( out, execFp[i].latency );
+   }
+   ckptPut( out, predictor.type );
+   ckptPut( out, predictor.indexBits );
+   ckptPut( out, (uint32_t)predictor.btb.size() );
+   ckptPut( out, (uint32_t)branchStats.size() );
+   ckptPut( out, storeSetsOn );
+   ckptPut( out, (uint32_t)storeSets.ssit.size() );
+   ckptPut( out, (uint32_t)storeSets.lfstIdx.size() );
+
+   // Architectural state; without the pipeline, resume at the oldest uncommitted instruction
+   unsigned pc              = PC;
+   if( !microarchitectural && !rob.isEmpty() )
+      pc                    = rob.peekHead()->dInstP->pc;
+   ckptPut( out, pc );
+   ckptPut( out, cycleCount );
+   ckptPut( out, instCount );
+   ckptPut( out, counters );
+   out.write( (const char*)branchStats.data(), branchStats.size() * sizeof(branchStatT) );
+   ckptPut( out, speculativeLoads );
+   ckptPut( out, memViolations );
+   ckptPut( out, loadReplays );
+   ckptPut( out, earlyRecoveries );
+   ckptPut( out, gprFile );
+   ckptPut( out, fpFile );
+
+   // Data memory, chunks still at the reset value are left out (only dirty pages can have any)
+   vector<unsigned> touched;
+   for(unsigned p = 0; p < data_memory.dirtyPages.size(); p++){
+      memPageT *page        = data_memory.peek( data_memory.dirtyPages[p] << MEM_PAGE_BITS );
+      for(unsigned offset = 0; offset < MEM_PAGE_SIZE; offset += CKPT_CHUNK){
+         for(unsigned i = 0; i < CKPT_CHUNK; i++){
+            if( page->bytes[offset + i] != (unsigned char)UNDEFINED ){
+               touched.push_back( ((data_memory.dirtyPages[p] << MEM_PAGE_BITS) + offset) / CKPT_CHUNK );
+               break;
+            }
+         }
+      }
+   }
+   ckptPut( out, (uint32_t)touched.size() );
+   for(unsigned t = 0; t < touched.size(); t++){
+      unsigned c            = touched[t];
+      ckptPut( out, c );
+      out.write( (const char*)data_memory.readWord( c * CKPT_CHUNK ), min( CKPT_CHUNK, data_memory_size - c * CKPT_CHUNK ) );
+   }
+
+   if( microarchitectural ){
+      ckptPut( out, memBlock );
+      ckptPut( out, fetchSeq );
+
+      // Dynamic instructions
+      out.write( (const char*)dInstPool.entries, dInstPool.size * sizeof(dynInstructT) );
+      ckptPut( out, dInstPool.freeCount );
+      ckptPut( out, dInstPool.live );
+      ckptPut( out, dInstPool.peak );
+      for(unsigned i = 0; i < dInstPool.freeCount; i++)
+         ckptPut( out, dInstToCode(dInstPool.freeList[i]) );
+
+      // ROB
+      ckptPut( out, rob.getHeadIndex() );
+      ckptPut( out, rob.getTailIndex() );
+      ckptPut( out, rob.getCount() );
+      for(unsigned i = 0; i < robSize; i++){
+         robT* robP         = rob.peekIndex(i);
+         ckptPut( out, dInstToCode(robP->dInstP) );
+         ckptPut( out, robP->ready );
+         ckptPut( out, robP->misPred );
+         ckptPut( out, robP->dest );
+         ckptPut( out, robP->value );
+         ckptPut( out, robP->memLatency );
+         ckptPut( out, robP->lsqIndex );
+         ckptPut( out, stationToCode(robP->jConsumers) );
+         ckptPut( out, stationToCode(robP->kConsumers) );
+      }
+
+      // Reservation stations and ready lists
+      for(int unit = 0; unit < RS_TOTAL; unit++){
+         resStPoolT* poolP  = &resStation[unit];
+         for(unsigned id = 0; id < poolP->size; id++){
+            resStationT* resP = &poolP->slots[id];
+            ckptPut( out, dInstToCode(resP->dInstP) );
+            ckptPut( out, resP->vj );
+            ckptPut( out, resP->vjR );
+            ckptPut( out, resP->vk );
+            ckptPut( out, resP->vkR );
+            ckptPut( out, resP->qj );
+            ckptPut( out, resP->qk );
+            ckptPut( out, resP->tagD );
+            ckptPut( out, resP->addr );
+            ckptPut( out, resP->id );
+            ckptPut( out, resP->inExec );
+            ckptPut( out, resP->age );
+            ckptPut( out, stationToCode(resP->jNext) );
+            ckptPut( out, stationToCode(resP->kNext) );
+            ckptPut( out, stationToCode(resP->readyNext) );
+            ckptPut( out, stationToCode(resP->readyPrev) );
+            ckptPut( out, poolP->ageNext[id] );
+            ckptPut( out, poolP->agePrev[id] );
+         }
+         out.write( (const char*)poolP->freeMap, poolP->words * sizeof(uint64_t) );
+         ckptPut( out, poolP->head );
+         ckptPut( out, poolP->tail );
+         ckptPut( out, poolP->count );
+      }
+      for(int i = 0; i < EX_TOTAL; i++){
+         ckptPut( out, stationToCode(readyList[i].head) );
+         ckptPut( out, stationToCode(readyList[i].tail) );
+      }
+
+      // Execution lanes, their pending events and the bypass lane
+      for(int i = 0; i < EX_TOTAL; i++){
+         for(int j = 0; j < execFp[i].numLanes; j++){
+            execWrLaneT* laneP = &execFp[i].lanes[j];
+            ckptPut( out, stationToCode(laneP->payloadP) );
+            ckptPut( out, laneP->busy );
+            ckptPut( out, laneP->output );
+            ckptPut( out, laneP->outputReady );
+         }
+      }
+      ckptPut( out, laneWheel.numBuckets );
+      out.write( (const char*)laneWheel.counts, laneWheel.numBuckets * sizeof(unsigned) );
+      out.write( (const char*)laneWheel.events, laneWheel.numBuckets * laneWheel.capacity * sizeof(laneEventT) );
+      ckptPut( out, (uint32_t)bypassLane.size() );
+      for(unsigned i = 0; i < bypassLane.size(); i++){
+         ckptPut( out, stationToCode(bypassLane[i].payloadP) );
+         ckptPut( out, bypassLane[i].output );
+         ckptPut( out, bypassLane[i].outputReady );
+      }
+
+      // Load/store queue
+      out.write( (const char*)lsq.entries, lsq.size * sizeof(lsqEntryT) );
+      out.write( (const char*)lsq.buckets, lsq.numBuckets * sizeof(int) );
+      ckptPut( out, lsq.head );
+      ckptPut( out, lsq.tail );
+      ckptPut( out, lsq.count );
+      ckptPut( out, lsq.unkHead );
+      ckptPut( out, lsq.unkTail );
+      ckptPut( out, lsq.nextSeq );
+
+      // Rename map checkpoints of the branches in flight
+      ckptPut( out, earlyRecovery );
+      out.write( (const char*)&renameCkpts[0], robSize * sizeof(renameCkptT) );
+
+      // Branch predictor tables, BTB and histories
+      out.write( (const char*)predictor.counters.data(), predictor.counters.size() * sizeof(uint8_t) );
+      for(int t = 0; t < TAGE_TABLES; t++)
+         out.write( (const char*)predictor.tagged[t].data(), predictor.tagged[t].size() * sizeof(tageEntryT) );
+      out.write( (const char*)predictor.btb.data(), predictor.btb.size() * sizeof(btbEntryT) );
+      ckptPut( out, predictor.history );
+      ckptPut( out, predictor.retiredHistory );
+      ckptPut( out, predictor.updates );
+
+      // Store sets; the LFST names load/store queue slots, restored above
+      out.write( (const char*)storeSets.ssit.data(), storeSets.ssit.size() * sizeof(int) );
+      out.write( (const char*)storeSets.lfstIdx.data(), storeSets.lfstIdx.size() * sizeof(int) );
+      out.write( (const char*)storeSets.lfstSeq.data(), storeSets.lfstSeq.size() * sizeof(uint64_t) );
+      ckptPut( out, storeSets.nextSet );
+      ckptPut( out, storeSets.fetched );
+   }
+
+   ASSERT( out.good(), "Unable to write checkpoint: %s", filename );
+}
+
+void sim_ooo::restore_checkpoint(const char *filename){
+   ifstream in( filename, ifstream::in | ifstream::binary );
+   ASSERT( in.is_open(), "Unable to open file: %s", filename );
+
+   char magic[sizeof(CKPT_MAGIC)];
+   in.read( magic, sizeof(magic) );
+   ASSERT( in.good() && memcmp(magic, CKPT_MAGIC, sizeof(magic)) == 0, "Not a checkpoint: %s", filename );
+   uint32_t version, flags;
+   ckptGet( in, version );
+   ASSERT( version == CKPT_VERSION, "Unsupported checkpoint version (=%u)", version );
+   ckptGet( in, flags );
+   bool microarchitectural  = flags & 1;
+
+   // Configuration
+   ckptCheck( in, data_memory_size, "memory size" );
+   ckptCheck( in, robSize, "ROB size" );
+   for(int i = 0; i < RS_TOTAL; i++)
+      ckptCheck( in, resStSize[i], "reservation stations" );
+   ckptCheck( in, lsq.size, "load/store queue size" );
+   for(int i = 0; i < EX_TOTAL; i++){
+      ckptCheck( in, execFp[i].numLanes, "execution units" );
+      ckptCheck( in, execFp[i].latency, "execution unit latency" );
+   }
+   ckptCheck( in, predictor.type, "branch predictor" );
+   ckptCheck( in, predictor.indexBits, "branch predictor size" );
+   ckptCheck( in, (uint32_t)predictor.btb.size(), "BTB size" );
+   ckptCheck( in, (uint32_t)branchStats.size(), "program size" );
+   ckptCheck( in, storeSetsOn, "store sets" );
+   ckptCheck( in, (uint32_t)storeSets.ssit.size(), "SSIT size" );
+   ckptCheck( in, (uint32_t)storeSets.lfstIdx.size(), "LFST size" );
+
+   flushPipeline(false);
+   memBlock                 = false;
+
+   // Architectural state
+   ckptGet( in, PC );
+   ckptGet( in, cycleCount );
+   ckptGet( in, instCount );
+   ckptGet( in, counters );
+   in.read( (char*)branchStats.data(), branchStats.size() * sizeof(branchStatT) );
+   ckptGet( in, speculativeLoads );
+   ckptGet( in, memViolations );
+   ckptGet( in, loadReplays );
+   ckptGet( in, earlyRecoveries );
+   ckptGet( in, gprFile );
+   ckptGet( in, fpFile );
+
+   data_memory.clear();
+   uint32_t numTouched;
+   ckptGet( in, numTouched );
+   for(uint32_t t = 0; t < numTouched; t++){
+      unsigned c;
+      ckptGet( in, c );
+      ASSERT( c * CKPT_CHUNK < data_memory_size, "Bad memory chunk in checkpoint (=%u)", c );
+      unsigned char chunk[CKPT_CHUNK];
+      unsigned len          = min( CKPT_CHUNK, data_memory_size - c * CKPT_CHUNK );
+      in.read( (char*)chunk, len );
+      ASSERT( in.good(), "Truncated checkpoint" );
+      data_memory.writeBytes( c * CKPT_CHUNK, chunk, len );
+   }
+
+   if( !microarchitectural ){
+      // Nothing is in flight, so no register is waiting on the ROB
+      for(int i = 0; i < NUM_GP_REGISTERS; i++)
+         gprFile[i].busy    = false;
+      for(int i = 0; i < NUM_FP_REGISTERS; i++)
+         fpFile[i].busy     = false;
+      return;
+   }
+
+   ckptGet( in, memBlock );
+   ckptGet( in, fetchSeq );
+
+   // Dynamic instructions
+   in.read( (char*)dInstPool.entries, dInstPool.size * sizeof(dynInstructT) );
+   ckptGet( in, dInstPool.freeCount );
+   ckptGet( in, dInstPool.live );
+   ckptGet( in, dInstPool.peak );
+   ASSERT( dInstPool.freeCount <= dInstPool.size, "Bad dynamic instruction pool in checkpoint" );
+   for(unsigned i = 0; i < dInstPool.size; i++)
+      dInstPool.entries[i].traceId = UNDEFINED;
+   for(unsigned i = 0; i < dInstPool.freeCount; i++){
+      int code;
+      ckptGet( in, code );
+      dInstPool.freeList[i] = codeToDInst(code);
+   }
+
+   // ROB
+   int head, tail, count;
+   ckptGet( in, head );
+   ckptGet( in, tail );
+   ckptGet( in, count );
+   rob.popAll();
+   rob.moveHead( head );
+   rob.moveTail( tail, count == (int)robSize, count );
+   for(unsigned i = 0; i < robSize; i++){
+      robT* robP            = rob.peekIndex(i);
+      int code;
+      ckptGet( in, code );
+      robP->dInstP          = codeToDInst(code);
+      ckptGet( in, robP->ready );
+      ckptGet( in, robP->misPred );
+      ckptGet( in, robP->dest );
+      ckptGet( in, robP->value );
+      ckptGet( in, robP->memLatency );
+      ckptGet( in, robP->lsqIndex );
+      ckptGet( in, code );
+      robP->jConsumers      = codeToStation(code);
+      ckptGet( in, code );
+      robP->kConsumers      = codeToStation(code);
+   }
+
+   // Reservation stations and ready lists
+   for(int unit = 0; unit < RS_TOTAL; unit++){
+      resStPoolT* poolP     = &resStation[unit];
+      for(unsigned id = 0; id < poolP->size; id++){
+         resStationT* resP  = &poolP->slots[id];
+         int code;
+         ckptGet( in, code );
+         resP->dInstP       = codeToDInst(code);
+         ckptGet( in, resP->vj );
+         ckptGet( in, resP->vjR );
+         ckptGet( in, resP->vk );
+         ckptGet( in, resP->vkR );
+         ckptGet( in, resP->qj );
+         ckptGet( in, resP->qk );
+         ckptGet( in, resP->tagD );
+         ckptGet( in, resP->addr );
+         ckptGet( in, resP->id );
+         ckptGet( in, resP->inExec );
+         ckptGet( in, resP->age );
+         ckptGet( in, code );
+         resP->jNext        = codeToStation(code);
+         ckptGet( in, code );
+         resP->kNext        = codeToStation(code);
+         ckptGet( in, code );
+         resP->readyNext    = codeToStation(code);
+         ckptGet( in, code );
+         resP->readyPrev    = codeToStation(code);
+         ckptGet( in, poolP->ageNext[id] );
+         ckptGet( in, poolP->agePrev[id] );
+      }
+      in.read( (char*)poolP->freeMap, poolP->words * sizeof(uint64_t) );
+      ckptGet( in, poolP->head );
+      ckptGet( in, poolP->tail );
+      ckptGet( in, poolP->count );
+   }
+   for(int i = 0; i < EX_TOTAL; i++){
+      int code;
+      ckptGet( in, code );
+      readyList[i].head     = codeToStation(code);
+      ckptGet( in, code );
+      readyList[i].tail     = codeToStation(code);
+   }
+
+   // Execution lanes, their pending events and the bypass lane
+   for(int i = 0; i < EX_TOTAL; i++){
+      for(int j = 0; j < execFp[i].numLanes; j++){
+         execWrLaneT* laneP = &execFp[i].lanes[j];
+         int code;
+         ckptGet( in, code );
+         laneP->payloadP    = codeToStation(code);
+         ckptGet( in, laneP->busy );
+         ckptGet( in, laneP->output );
+         ckptGet( in, laneP->outputReady );
+      }
+   }
+   ckptCheck( in, laneWheel.numBuckets, "execution lane calendar" );
+   in.read( (char*)laneWheel.counts, laneWheel.numBuckets * sizeof(unsigned) );
+   in.read( (char*)laneWheel.events, laneWheel.numBuckets * laneWheel.capacity * sizeof(laneEventT) );
+   uint32_t numBypass;
+   ckptGet( in, numBypass );
+   for(uint32_t i = 0; i < numBypass; i++){
+      execWrLaneT lane;
+      int code;
+      ckptGet( in, code );
+      lane.payloadP         = codeToStation(code);
+      lane.busy             = false;
+      ckptGet( in, lane.output );
+      ckptGet( in, lane.outputReady );
+      bypassLane.push_back( lane );
+   }
+
+   // Load/store queue
+   in.read( (char*)lsq.entries, lsq.size * sizeof(lsqEntryT) );
+   in.read( (char*)lsq.buckets, lsq.numBuckets * sizeof(int) );
+   ckptGet( in, lsq.head );
+   ckptGet( in, lsq.tail );
+   ckptGet( in, lsq.count );
+   ckptGet( in, lsq.unkHead );
+   ckptGet( in, lsq.unkTail );
+   ckptGet( in, lsq.nextSeq );
+
+   // Rename map checkpoints of the branches in flight
+   ckptCheck( in, earlyRecovery, "early recovery" );
+   in.read( (char*)&renameCkpts[0], robSize * sizeof(renameCkptT) );
+
+   // Branch predictor tables, BTB and histories
+   in.read( (char*)predictor.counters.data(), predictor.counters.size() * sizeof(uint8_t) );
+   for(int t = 0; t < TAGE_TABLES; t++)
+      in.read( (char*)predictor.tagged[t].data(), predictor.tagged[t].size() * sizeof(tageEntryT) );
+   in.read( (char*)predictor.btb.data(), predictor.btb.size() * sizeof(btbEntryT) );
+   ckptGet( in, predictor.history );
+   ckptGet( in, predictor.retiredHistory );
+   ckptGet( in, predictor.updates );
+
+   // Store sets; the LFST names load/store queue slots, restored above
+   in.read( (char*)storeSets.ssit.data(), storeSets.ssit.size() * sizeof(int) );
+   in.read( (char*)storeSets.lfstIdx.data(), storeSets.lfstIdx.size() * sizeof(int) );
+   in.read( (char*)storeSets.lfstSeq.data(), storeSets.lfstSeq.size() * sizeof(uint64_t) );
+   ckptGet( in, storeSets.nextSet );
+   ckptGet( in, storeSets.fetched );
+}
+//-------------------------------- CHECKPOINT END ---------------------------------
+
 //-------------------------------- Fifo FUNCS BEGIN -------------------------------
 template <class T> Fifo<T>::Fifo( int size ){
    head              = 0;
@@ -1316,21 +2912,29 @@ int sim_ooo::labelResolve(string label,
    return UNDEFINED;
 }
 
-void sim_ooo::getReg( istringstream& buff_iss, uint32_t& reg, bool& regF, bool with_brackets ){
-   string reg_i_or_f, open_bracket, closed_bracket;
-
-   if( with_brackets )
-      buff_iss >> setw(1) >> /*open_bracket >> setw(1) >> */ reg_i_or_f >> reg >> closed_bracket;
-   else
-      buff_iss >> setw(1) >> reg_i_or_f >> reg;
-
-   regF  = ( reg_i_or_f == "F" ) || ( reg_i_or_f == "f" );
+// Perfect hash of the opcode mnemonics into 64 slots (index into instr_names, -1 if empty):
+// (3*c[0] + 3*c[1] + 6*c[n-2] + c[n-1]) & 63 is distinct for every opcode
+static const signed char opcode_hash[64] = { -1, -1, 7, -1, -1, 6, 22, 1, 0, -1, -1, -1, -1, 10, 13, 5,
+                                             -1, -1, -1, 19, -1, 14, -1, 25, 12, -1, -1, 23, -1, -1, -1, -1,
+                                             -1, 4, 18, -1, -1, -1, 21, -1, 15, -1, 11, 2, -1, 17, -1, -1,
+                                             9, 26, -1, 8, -1, -1, -1, -1, 3, -1, 24, 20, 16, -1, 27, -1 };
+
+static bool opcodeLookup( const char *token, unsigned len, opcode_t& opcode ){
+   if( len < 2 )
+      return false;
+   const unsigned char *c = (const unsigned char*)token;
+   int index = opcode_hash[(3*c[0] + 3*c[1] + 6*c[len - 2] + c[len - 1]) & 63];
+   if( index < 0 || strlen( instr_names[index] ) != len || memcmp( instr_names[index], token, len ) != 0 )
+      return false;
+   opcode    = (opcode_t)index;
+   return true;
 }
 
 /*
- * Details     : 1. Parses a given file using c++ ifstream, 
- *                  delimits string based on opcode and its
- *                  corresponding arguments
+ * Details     : 1. Lexes the source in a single pass, in place
+ *                  (asmLexerT): one line per instruction, an
+ *                  optional "label:" before the opcode, and
+ *                  the opcode looked up in a perfect hash table
  *               2. Implements runtime label disambiguation
  *                  process for fast label to PC/offset
  *                  lookup
@@ -1352,16 +2956,10 @@ void sim_ooo::getReg( istringstream& buff_iss, uint32_t& reg, bool& regF, bool w
  * Returns     : Number of instructions successfully parsed
  * Side Effects: Populates class variable instMemory
  *
- * NOTES       : -NA-
+ * NOTES       : instruction PCs are set by load_program()
  */
-int sim_ooo::parse( const string filename, unsigned base_address ){
+int sim_ooo::parse( const char *source, size_t length ){
    int line_num = 0;
-   string buff;
-
-   // ASM handle to file
-   ifstream asm_h;
-   asm_h.open( filename, ifstream::in );
-   ASSERT( asm_h.is_open(), "Unable to open file: %s", filename.c_str() ); 
 
    // Map for label to line number lookup used in offset
    // calculation (1)
@@ -1370,133 +2968,85 @@ int sim_ooo::parse( const string filename, unsigned base_address ){
    // Store all index to instMemory that have unresolved labels (4)
    map <string, vector <int>> unresolved_label_index;
 
-   // Loop to iterate through each line in asm and extract
-   // instructions
-   // getline fetches string till a new line character is reached
-   while( getline( asm_h, buff ) ) {
-      instMemory               = (instructPT*) realloc(instMemory, (line_num + 1)*sizeof(instructPT));
-      instructPT instructP     = new instructT;
-      instructP->pc            = (line_num * 4) + base_address;
-
-      instMemory[line_num]     = instructP;
-
-      // At this point in code, buff has the entire line including
-      // opcode and its arguments (eg. ADDI	R2 R0 0xA000)
-      
-      // Making istringstream out of buff gives us the capability
-      // to extract strings delimited by whitespace easily
-      // for ADDI	R2 R0 0xA000, istringstream would yeild 4 strings
-      // namely, ADDI, R2, R0, 0xA000 which can be quite handy
-      // NOTE: We cannot use extraction operator (described below)
-      // on strings and hence, we use istringstream
-      istringstream buff_iss(buff);
-
-      // String to hold opcode
-      string opcode;
-      // String to hold info on integer/floating identifier
-      // in instruction
-      string label;
-      string imm;
-
-      // Loading up 1st string a.k.a opcode from buff_iss
-      // >> is also called 'extraction' operator which extracts
-      // 1st string out of buff_iss and assigns it to opcode
-      // NOTE: opcode will be moved (i.e., will be removed from buff_is)
-      buff_iss >> opcode;
-
-      if( opcode_2str.count( opcode ) <= 0 ){
-         // string.back() gives the last character in a string
-         ASSERT( opcode.back() == ':', "Unkown 1st token(%s) encountered", opcode.c_str() );
-
-         // At this point in code, opcode actually stores label except for last
-         // character which is a ':'
-         string label              = opcode.substr(0, opcode.length() - 1);
+   // One instruction per line, in a single allocation
+   instMemory.clear();
+   instMemory.reserve( count( source, source + length, '\n' ) + 1 );
+
+   asmLexerT lex( source, length );
+   while( lex.pos < lex.end ) {
+      instMemory.push_back( instructT() );
+      instructPT instructP     = &instMemory.back();
+
+      unsigned len;
+      const char *token        = lex.token( len );
+      opcode_t opcode;
+      if( !opcodeLookup( token, len, opcode ) ){
+         ASSERT( len > 0, "Missing opcode at line %d", lex.line );
+         ASSERT( token[len - 1] == ':', "Unkown 1st token(%.*s) encountered", len, token );
 
          // label must be saved along with line number for quick 
          // lookup and disambiguation process (1)
+         string label              = string( token, len - 1 );
          label_to_linenum[ label ] = line_num;
 
          // Since we have got a new label, we should check for any ambiguities
          // and resolve them at this step (5)
-         // NOTE: opcode here is the label
-         if( unresolved_label_index.find( label ) != unresolved_label_index.end() ){
-            // We do have some unresolved instructions..
-            vector <int> unresolved_index = unresolved_label_index[label];
-            for( unsigned index = 0; index < unresolved_index.size(); index++ ){
+         map <string, vector <int>>::iterator unresolvedI = unresolved_label_index.find( label );
+         if( unresolvedI != unresolved_label_index.end() ){
+            for( unsigned index = 0; index < unresolvedI->second.size(); index++ ){
                // Disambiguate all previous encounters
-               int inst_index              = unresolved_index[index];
-               instMemory[inst_index]->imm = indexToOffset( line_num, inst_index );
+               int inst_index              = unresolvedI->second[index];
+               instMemory[inst_index].imm  = indexToOffset( line_num, inst_index );
             }
             // Delete the entry from unresolved list
-            unresolved_label_index.erase( label );
+            unresolved_label_index.erase( unresolvedI );
          }
 
-         // Since the assumed opcode was a label, let's extract next token
-         // and assign it to opcode
-         buff_iss >> opcode;
+         // The label is followed by the opcode
+         token                     = lex.token( len );
+         ASSERT( opcodeLookup( token, len, opcode ), "Unkown opcode(%.*s) encountered", len, token );
       }
+      instructP->opcode        = opcode;
 
-      // Translate string to enum for handy usage
-      instructP->opcode        = opcode_2str[ opcode ];
-
-      //FIX_ME #1: use reg_i_or_f to flood struct field
-      // setw(n) sets the number of characters to extract
-      // eg., let's assume buff_iss has "R2 R0 0xA000"
-      // buff_iss >> setw(1) >> reg_i_or_f
-      // will extract R (1 character) from "R2" and stash
-      // it in reg_i_or_f
       switch( instructP->opcode ){
          case ADD ... DIV:
          case ADDS ... DIVS:
-            // The following 3 lines store respective I/F in
-            // intermediate values of reg_i_or_f and converts
-            // string to int implicitly as dst, src1, src2 
-            // are of type int
-            getReg( buff_iss, instructP->dst , instructP->dstF );
-            getReg( buff_iss, instructP->src1, instructP->src1F );
-            getReg( buff_iss, instructP->src2, instructP->src2F );
+            lex.reg( instructP->dst , instructP->dstF );
+            lex.reg( instructP->src1, instructP->src1F );
+            lex.reg( instructP->src2, instructP->src2F );
             instructP->dstValid   = true;
             instructP->src1Valid  = true;
             instructP->src2Valid  = true;
             break;
 
          case BEQZ ... BGEZ:
-            getReg( buff_iss, instructP->src1, instructP->src1F );
-            buff_iss >> label;
-            instructP->imm        = labelResolve( label, label_to_linenum, unresolved_label_index, line_num );
+            lex.reg( instructP->src1, instructP->src1F );
+            token                 = lex.token( len );
+            instructP->imm        = labelResolve( string( token, len ), label_to_linenum, unresolved_label_index, line_num );
             instructP->src1Valid  = true;
             instructP->is_branch  = true;
             break;
 
          case ADDI ... ANDI:
-            getReg( buff_iss, instructP->dst , instructP->dstF );
-            getReg( buff_iss, instructP->src1, instructP->src1F );
-            buff_iss >> imm;
-            // stod takes care of decimal, hex (0x) string internally
-            instructP->imm        = stod(imm);
+            lex.reg( instructP->dst , instructP->dstF );
+            lex.reg( instructP->src1, instructP->src1F );
+            instructP->imm        = lex.number();
             instructP->dstValid   = true;
             instructP->src1Valid  = true;
             break;
 
          case JUMP:
-            buff_iss >> label;
-            instructP->imm        = labelResolve( label, label_to_linenum, unresolved_label_index, line_num );
+            token                 = lex.token( len );
+            instructP->imm        = labelResolve( string( token, len ), label_to_linenum, unresolved_label_index, line_num );
             instructP->is_branch  = true;
             break;
 
          case LW:
          case LWS:
-            getReg( buff_iss, instructP->dst , instructP->dstF );
             // Format to parse at this point of code: %d(R%d)
-            // Interestingly, ->imm field is of type int
-            // extracting from buff_iss onto ->imm will stop right
-            // before "(" which is exactly what we want
-            getline(buff_iss, imm, '(');
-            instructP->imm        = stod(imm);
-            // Following line is self explanatory on what is happening
-            // at this point in code
-            // Format to parse at this point of code: (R%d)
-            getReg( buff_iss, instructP->src1, instructP->src1F, true );
+            lex.reg( instructP->dst , instructP->dstF );
+            instructP->imm        = lex.offset();
+            lex.reg( instructP->src1, instructP->src1F, true );
             instructP->dstValid   = true;
             instructP->src1Valid  = true;
             instructP->is_load    = true;
@@ -1504,17 +3054,10 @@ int sim_ooo::parse( const string filename, unsigned base_address ){
 
          case SW:
          case SWS:
-            getReg( buff_iss, instructP->src1, instructP->src1F );
             // Format to parse at this point of code: %d(R%d)
-            // Interestingly, ->imm field is of type int
-            // extracting from buff_iss onto ->imm will stop right
-            // before "(" which is exactly what we want
-            getline(buff_iss, imm, '(');
-            instructP->imm        = stod(imm);
-            // Following line is self explanatory on what is happening
-            // at this point in code
-            // Format to parse at this point of code: (R%d)
-            getReg( buff_iss, instructP->src2, instructP->src2F, true );
+            lex.reg( instructP->src1, instructP->src1F );
+            instructP->imm        = lex.offset();
+            lex.reg( instructP->src2, instructP->src2F, true );
             instructP->src2Valid  = true;
             instructP->src1Valid  = true;
             instructP->is_store   = true;
@@ -1527,6 +3070,7 @@ int sim_ooo::parse( const string filename, unsigned base_address ){
             ASSERT(false, "Unknown operation encountered");
             break;
       }
+      lex.nextLine();
       line_num++;
    }
 
@@ -1538,5 +3082,120 @@ int sim_ooo::parse( const string filename, unsigned base_address ){
 
 //----------------------------------------------PARSING OPERATION ENDS-----------------------------------//
 
+//----------------------------------------------PROGRAM CACHE BEGIN--------------------------------------//
+// Cache file: magic, version, source hash, instruction count, then per instruction
+// the opcode, a flag word, three registers (0xFF: UNDEFINED) and the immediate
+static const char     PROG_MAGIC[8]  = "OOOPROG";
+static const uint32_t PROG_VERSION   = 1;
+static const unsigned PROG_RECORD    = 10;
+
+enum { PROG_DST_VALID = 1, PROG_SRC1_VALID = 2, PROG_SRC2_VALID = 4, PROG_DST_F = 8, PROG_SRC1_F = 16,
+       PROG_SRC2_F = 32, PROG_BRANCH = 64, PROG_LOAD = 128, PROG_STORE = 256 };
+
+// FNV-1a
+uint64_t sim_ooo::programHash(const char *source, size_t length){
+   uint64_t hash            = 0xcbf29ce484222325ULL;
+   for(size_t i = 0; i < length; i++)
+      hash                  = (hash ^ (unsigned char)source[i]) * 0x100000001b3ULL;
+   return hash;
+}
+
+// A register field holds 0xFF (UNDEFINED) or a register of its file, and a valid operand is never UNDEFINED
+static bool progRegisterOk(unsigned char reg, uint16_t flags, uint16_t validFlag, uint16_t fpFlag){
+   if( reg == 0xFF )
+      return !(flags & validFlag);
+   return reg < ((flags & fpFlag) ? NUM_FP_REGISTERS : NUM_GP_REGISTERS);
+}
+
+// False (and instruction memory untouched) unless the cache holds this source
+// and every record decodes to a valid instruction
+bool sim_ooo::readProgramCache(const string& filename, uint64_t hash){
+   string image;
+   if( !readFile( filename.c_str(), image ) )
+      return false;
+
+   const size_t header      = sizeof(PROG_MAGIC) + sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t);
+   if( image.size() < header || memcmp( image.data(), PROG_MAGIC, sizeof(PROG_MAGIC) ) != 0 )
+      return false;
+   const char *p            = image.data() + sizeof(PROG_MAGIC);
+   uint32_t version, count;
+   uint64_t cachedHash;
+   memcpy( &version, p, sizeof(version) );            p += sizeof(version);
+   memcpy( &cachedHash, p, sizeof(cachedHash) );      p += sizeof(cachedHash);
+   memcpy( &count, p, sizeof(count) );                p += sizeof(count);
+   if( version != PROG_VERSION || cachedHash != hash || image.size() != header + (size_t)count * PROG_RECORD )
+      return false;
+
+   // A corrupt or foreign cache must not index past the register files
+   for(uint32_t i = 0; i < count; i++){
+      const unsigned char *r = (const unsigned char*)p + (size_t)i * PROG_RECORD;
+      uint16_t flags        = r[1] | (r[2] << 8);
+      if( r[0] >= NUM_OPCODES || !progRegisterOk( r[3], flags, PROG_DST_VALID, PROG_DST_F ) ||
+          !progRegisterOk( r[4], flags, PROG_SRC1_VALID, PROG_SRC1_F ) || !progRegisterOk( r[5], flags, PROG_SRC2_VALID, PROG_SRC2_F ) )
+         return false;
+   }
+
+   instMemory.assign( count, instructT() );
+   for(uint32_t i = 0; i < count; i++, p += PROG_RECORD){
+      instructT& inst       = instMemory[i];
+      const unsigned char *r = (const unsigned char*)p;
+      uint16_t flags        = r[1] | (r[2] << 8);
+      inst.opcode           = (opcode_t)r[0];
+      inst.dst              = r[3] == 0xFF ? UNDEFINED : r[3];
+      inst.src1             = r[4] == 0xFF ? UNDEFINED : r[4];
+      inst.src2             = r[5] == 0xFF ? UNDEFINED : r[5];
+      memcpy( &inst.imm, r + 6, sizeof(inst.imm) );
+      inst.dstValid         = flags & PROG_DST_VALID;
+      inst.src1Valid        = flags & PROG_SRC1_VALID;
+      inst.src2Valid        = flags & PROG_SRC2_VALID;
+      inst.dstF             = flags & PROG_DST_F;
+      inst.src1F            = flags & PROG_SRC1_F;
+      inst.src2F            = flags & PROG_SRC2_F;
+      inst.is_branch        = flags & PROG_BRANCH;
+      inst.is_load          = flags & PROG_LOAD;
+      inst.is_store         = flags & PROG_STORE;
+   }
+   return true;
+}
+
+// Best effort: a cache that cannot be written is skipped. The file is written
+// aside under a name unique to this process and instance, then renamed, so
+// concurrent simulators never read a partial one
+void sim_ooo::writeProgramCache(const string& filename, uint64_t hash){
+   string image( PROG_MAGIC, sizeof(PROG_MAGIC) );
+   uint32_t count           = instMemory.size();
+   image.append( (const char*)&PROG_VERSION, sizeof(PROG_VERSION) );
+   image.append( (const char*)&hash, sizeof(hash) );
+   image.append( (const char*)&count, sizeof(count) );
+   for(uint32_t i = 0; i < count; i++){
+      const instructT& inst = instMemory[i];
+      uint16_t flags        = (inst.dstValid ? PROG_DST_VALID : 0) | (inst.src1Valid ? PROG_SRC1_VALID : 0) |
+                              (inst.src2Valid ? PROG_SRC2_VALID : 0) | (inst.dstF ? PROG_DST_F : 0) |
+                              (inst.src1F ? PROG_SRC1_F : 0) | (inst.src2F ? PROG_SRC2_F : 0) |
+                              (inst.is_branch ? PROG_BRANCH : 0) | (inst.is_load ? PROG_LOAD : 0) |
+                              (inst.is_store ? PROG_STORE : 0);
+      unsigned char r[PROG_RECORD];
+      r[0]                  = inst.opcode;
+      r[1]                  = flags & 0xFF;
+      r[2]                  = flags >> 8;
+      r[3]                  = inst.dst == UNDEFINED ? 0xFF : inst.dst;
+      r[4]                  = inst.src1 == UNDEFINED ? 0xFF : inst.src1;
+      r[5]                  = inst.src2 == UNDEFINED ? 0xFF : inst.src2;
+      memcpy( r + 6, &inst.imm, sizeof(inst.imm) );
+      image.append( (const char*)r, PROG_RECORD );
+   }
+
+   ostringstream aside;
+   aside << filename << ".tmp" << dec << getpid() << "." << hex << (uintptr_t)this;
+   ofstream out( aside.str().c_str(), ofstream::out | ofstream::trunc | ofstream::binary );
+   if( !out.is_open() )
+      return;
+   out.write( image.data(), image.size() );
+   out.close();
+   if( !out.good() || rename( aside.str().c_str(), filename.c_str() ) != 0 )
+      remove( aside.str().c_str() );
+}
+//----------------------------------------------PROGRAM CACHE END----------------------------------------//
+
 
 
@@ -16,6 +16,9 @@
 #include <map>
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <sys/mman.h>
+#include <new>
 
 using namespace std;
 
@@ -38,6 +41,18 @@ typedef enum {INTEGER, ADDER, MULTIPLIER, DIVIDER, MEMORY, EX_TOTAL} exe_unit_t;
 
 typedef enum{ISSUE, EXECUTE, WRITE_RESULT, COMMIT} stage_t;
 
+// Structure that kept issue from filling its width in a cycle
+typedef enum {STALL_ROB, STALL_RS, STALL_LSQ, STALL_TOTAL} issue_stall_t;
+
+// Why a ready reservation station was not sent to execution in a cycle
+typedef enum {STALL_LANE_BUSY, STALL_MEM_BLOCK, STALL_STORE_CONFLICT, DISPATCH_STALL_TOTAL} dispatch_stall_t;
+
+// Why nothing committed in a cycle
+typedef enum {STALL_ROB_EMPTY, STALL_NOT_READY, STALL_STORE_MEMORY, COMMIT_STALL_TOTAL} commit_stall_t;
+
+// Direction predictor consulted by fetch (not-taken: always fetch the next instruction)
+typedef enum {PREDICT_NOT_TAKEN, PREDICT_BIMODAL, PREDICT_GSHARE, PREDICT_TAGE, PREDICTOR_TOTAL} predictor_t;
+
 const string opcode_str[] = {"LW", "SW", "ADD", "SUB", "XOR", "OR", "AND", "MULT", "DIV", "ADDI", "SUBI", "XORI", "ORI", "ANDI", "BEQZ", "BNEZ", "BLTZ", "BGTZ", "BLEZ", "BGEZ", "JUMP", "EOP", "LWS", "SWS", "ADDS", "SUBS", "MULTS", "DIVS"};
 
 
@@ -134,10 +149,405 @@ struct instStatT{
    }
 };
 
+//Execution history on file: a magic string, then per instruction the PC and the
+//issue/execute/write result/commit cycles as varints. The PC is a delta to the
+//previous record's PC, the issue cycle a delta to the previous record's issue cycle,
+//every other cycle a delta to the cycle before it in the same record. Deltas are
+//zigzag encoded and stored plus one (up to 2^32, hence 64-bit varints), so that
+//0 stands for UNDEFINED
+#define LOG_MAGIC "OOOLOG1"
+#define LOG_BUFFER_SIZE (64*1024)
+#define LOG_MAX_RECORD 25 //five varints of at most 5 bytes
+
+struct logSinkT{
+   ofstream           out;
+   unsigned char      *buffer;
+   unsigned           used;
+   unsigned           prevPc;
+   unsigned           prevIssue;
+
+   logSinkT(){
+      buffer           = NULL;
+      used             = 0;
+   }
+
+   ~logSinkT(){
+      close();
+      delete [] buffer;
+   }
+
+   bool isOpen(){
+      return out.is_open();
+   }
+
+   void open(const char *filename){
+      close();
+      out.open( filename, ofstream::out | ofstream::trunc | ofstream::binary );
+      ASSERT( out.is_open(), "Unable to open file: %s", filename );
+      if( buffer == NULL )
+         buffer        = new unsigned char[LOG_BUFFER_SIZE];
+      out.write( LOG_MAGIC, sizeof(LOG_MAGIC) );
+      used             = 0;
+      prevPc           = 0;
+      prevIssue        = 0;
+   }
+
+   void flush(){
+      if( used > 0 )
+         out.write( (const char*)buffer, used );
+      out.flush();
+      used             = 0;
+   }
+
+   void close(){
+      if( !isOpen() )
+         return;
+      flush();
+      out.close();
+   }
+
+   void putVarint(uint64_t value){
+      while( value >= 0x80 ){
+         buffer[used++] = (value & 0x7F) | 0x80;
+         value        >>= 7;
+      }
+      buffer[used++]   = value;
+   }
+
+   void putDelta(unsigned value, unsigned base){
+      if( value == UNDEFINED ){
+         putVarint( 0 );
+         return;
+      }
+      int32_t delta    = value - base;
+      putVarint( (uint64_t)(((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31)) + 1 );
+   }
+
+   void put(const instStatT& stat){
+      if( used + LOG_MAX_RECORD > LOG_BUFFER_SIZE ){
+         out.write( (const char*)buffer, used );
+         used          = 0;
+      }
+      putDelta( stat.pc, prevPc );
+      putDelta( stat.t_issue, prevIssue );
+      unsigned base    = stat.t_issue == UNDEFINED ? prevIssue : stat.t_issue;
+      putDelta( stat.t_execute, base );
+      base             = stat.t_execute == UNDEFINED ? base : stat.t_execute;
+      putDelta( stat.t_wr, base );
+      base             = stat.t_wr == UNDEFINED ? base : stat.t_wr;
+      putDelta( stat.t_commit, base );
+      if( stat.pc != UNDEFINED )
+         prevPc        = stat.pc;
+      if( stat.t_issue != UNDEFINED )
+         prevIssue     = stat.t_issue;
+   }
+};
+
+//Reads back the records written by logSinkT
+struct logReaderT{
+   ifstream           in;
+   unsigned           prevPc;
+   unsigned           prevIssue;
+
+   void open(const char *filename){
+      in.open( filename, ifstream::in | ifstream::binary );
+      ASSERT( in.is_open(), "Unable to open file: %s", filename );
+      char magic[sizeof(LOG_MAGIC)];
+      in.read( magic, sizeof(magic) );
+      ASSERT( in.good() && memcmp(magic, LOG_MAGIC, sizeof(magic)) == 0, "Not an execution log: %s", filename );
+      prevPc           = 0;
+      prevIssue        = 0;
+   }
+
+   // false at the end of the file
+   bool getVarint(uint64_t& value){
+      value            = 0;
+      for(int shift = 0; shift < 35; shift += 7){
+         int c         = in.get();
+         if( c == EOF ){
+            ASSERT( shift == 0, "Truncated execution log" );
+            return false;
+         }
+         value        |= (uint64_t)(c & 0x7F) << shift;
+         if( !(c & 0x80) )
+            return true;
+      }
+      ASSERT( false, "Corrupt execution log" );
+      return false;
+   }
+
+   // Undoes logSinkT::putDelta
+   static unsigned fromCode(uint64_t code, unsigned base){
+      if( code == 0 )
+         return UNDEFINED;
+      ASSERT( code <= ((uint64_t)1 << 32), "Corrupt execution log" );
+      uint32_t zigzag  = code - 1;
+      int32_t delta    = (zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+      return base + delta;
+   }
+
+   unsigned getDelta(unsigned base){
+      uint64_t code;
+      ASSERT( getVarint(code), "Truncated execution log" );
+      return fromCode( code, base );
+   }
+
+   // false once all records have been read
+   bool next(instStatT& stat){
+      uint64_t code;
+      if( !getVarint(code) )
+         return false;
+      stat.pc          = fromCode( code, prevPc );
+      stat.t_issue     = getDelta( prevIssue );
+      unsigned base    = stat.t_issue == UNDEFINED ? prevIssue : stat.t_issue;
+      stat.t_execute   = getDelta( base );
+      base             = stat.t_execute == UNDEFINED ? base : stat.t_execute;
+      stat.t_wr        = getDelta( base );
+      base             = stat.t_wr == UNDEFINED ? base : stat.t_wr;
+      stat.t_commit    = getDelta( base );
+      if( stat.pc != UNDEFINED )
+         prevPc        = stat.pc;
+      if( stat.t_issue != UNDEFINED )
+         prevIssue     = stat.t_issue;
+      return true;
+   }
+};
+
+#define TAGE_TABLES 4
+
+//What fetch predicted for a branch and the table entries it looked up, kept
+//with the instruction so that commit trains the entries that made the prediction
+struct branchPredT{
+   uint32_t           nextPC;
+   uint64_t           history;      // global history when fetched (set for every instruction)
+   bool               taken;
+   bool               altTaken;
+   int                provider;     // tagged table that predicted (TAGE), -1 for the counter table
+   uint32_t           index;        // counter table entry
+   uint32_t           tagIndex[TAGE_TABLES];
+   uint16_t           tag[TAGE_TABLES];
+};
+
 struct dynInstructT : public instructT{
    instStatT stat;
+   unsigned  traceId;
+   branchPredT pred;
+   dynInstructT(){
+      traceId  = UNDEFINED;
+   }
    dynInstructT( instructT input ){
       copy(input);
+      traceId  = UNDEFINED;
+   }
+};
+
+class sim_ooo;
+
+//Execute step of an instruction: returns its output (the next PC for branches) and sets taken for a taken branch
+typedef uint32_t (*exHandlerT)(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken);
+
+//Instruction decoded once, when the program is loaded, with everything the
+//pipeline needs to know about it; indexed by (pc - base address) / 4, one per cache line
+struct alignas(64) microOpT{
+   instructT          inst;
+   exHandlerT         execute;
+   exe_unit_t         unit;
+   res_station_t      station;
+   unsigned           latency;
+};
+
+//Pipeline trace in the Kanata (version 0004) text format read by the Konata
+//visualizer: instructions appear at issue, start a stage on every transition
+//and leave on commit or squash. Commands are written in cycle order, so the
+//trace is produced as the simulation goes
+#define TRACE_BUFFER_SIZE (64*1024)
+#define TRACE_MAX_COMMAND 96
+
+struct traceWriterT{
+   ofstream           out;
+   char               *buffer;
+   unsigned           used;
+   unsigned           cycle;
+   unsigned           nextId;
+   unsigned           retired;
+
+   traceWriterT(){
+      buffer           = NULL;
+      used             = 0;
+   }
+
+   ~traceWriterT(){
+      close();
+      delete [] buffer;
+   }
+
+   bool isOpen(){
+      return out.is_open();
+   }
+
+   void open(const char *filename, unsigned startCycle){
+      close();
+      out.open( filename, ofstream::out | ofstream::trunc | ofstream::binary );
+      ASSERT( out.is_open(), "Unable to open file: %s", filename );
+      if( buffer == NULL )
+         buffer        = new char[TRACE_BUFFER_SIZE];
+      used             = 0;
+      cycle            = startCycle;
+      nextId           = 0;
+      retired          = 0;
+      putStr( "Kanata\t0004\nC=\t" );
+      putNum( cycle );
+      putChar( '\n' );
+   }
+
+   void flush(){
+      if( used > 0 )
+         out.write( buffer, used );
+      out.flush();
+      used             = 0;
+   }
+
+   void close(){
+      if( !isOpen() )
+         return;
+      flush();
+      out.close();
+   }
+
+   void putChar(char c){
+      buffer[used++]   = c;
+   }
+
+   void putStr(const char *str){
+      while( *str )
+         buffer[used++] = *str++;
+   }
+
+   void putNum(unsigned value){
+      char digits[10];
+      int n            = 0;
+      do{
+         digits[n++]   = '0' + value % 10;
+         value        /= 10;
+      } while( value );
+      while( n > 0 )
+         buffer[used++] = digits[--n];
+   }
+
+   void putHex(unsigned value){
+      for(int shift = 28; shift >= 0; shift -= 4)
+         buffer[used++] = "0123456789abcdef"[(value >> shift) & 0xF];
+   }
+
+   void putReg(uint32_t reg, bool isF){
+      putChar( ' ' );
+      putChar( isF ? 'F' : 'R' );
+      putNum( reg );
+   }
+
+   // Starts a command at cycle "now": makes room for it and advances the clock
+   void begin(char command, unsigned id, unsigned now){
+      if( used + TRACE_MAX_COMMAND > TRACE_BUFFER_SIZE ){
+         out.write( buffer, used );
+         used          = 0;
+      }
+      if( now != cycle ){
+         putStr( "C\t" );
+         putNum( now - cycle );
+         putChar( '\n' );
+         cycle         = now;
+      }
+      putChar( command );
+      putChar( '\t' );
+      putNum( id );
+      putChar( '\t' );
+   }
+
+   // New instruction, labelled with its PC, opcode and registers; returns its id
+   unsigned issue(instructT& instruct, unsigned now){
+      unsigned id      = nextId++;
+      begin( 'I', id, now );
+      putNum( id );
+      putStr( "\t0\n" );
+      begin( 'L', id, now );
+      putStr( "0\t0x" );
+      putHex( instruct.pc );
+      putStr( ": " );
+      putStr( opcode_str[instruct.opcode].c_str() );
+      if( instruct.dstValid )
+         putReg( instruct.dst, instruct.dstF );
+      if( instruct.src1Valid )
+         putReg( instruct.src1, instruct.src1F );
+      if( instruct.src2Valid )
+         putReg( instruct.src2, instruct.src2F );
+      putChar( '\n' );
+      return id;
+   }
+
+   // Moves an instruction into "stage", ending the previous one
+   void stage(unsigned id, stage_t stage, unsigned now){
+      static const char *stageLabel[NUM_STAGES] = {"Is", "Ex", "Wr", "Cm"};
+      begin( 'S', id, now );
+      putStr( "0\t" );
+      putStr( stageLabel[stage] );
+      putChar( '\n' );
+   }
+
+   // Instruction leaves the pipeline: committed, or squashed if "flushed"
+   void retire(unsigned id, bool flushed, unsigned now){
+      begin( 'R', id, now );
+      putNum( flushed ? 0 : retired++ );
+      putStr( flushed ? "\t1\n" : "\t0\n" );
+   }
+};
+
+//Free-list pool of dynamic instructions
+//Every dynamic instruction lives in the ROB, so the pool is sized to it and
+//entries are recycled when they leave the ROB (commit or squash)
+struct dynInstPoolT{
+   dynInstructT   *entries;
+   dynInstructPT  *freeList;
+   unsigned       size;
+   unsigned       freeCount;
+   unsigned       live;
+   unsigned       peak;
+
+   dynInstPoolT(){
+      entries        = NULL;
+      freeList       = NULL;
+      size           = 0;
+      freeCount      = 0;
+      live           = 0;
+      peak           = 0;
+   }
+
+   ~dynInstPoolT(){
+      delete [] entries;
+      delete [] freeList;
+   }
+
+   void init(unsigned size){
+      this->size     = size;
+      entries        = new dynInstructT[size];
+      freeList       = new dynInstructPT[size];
+      for( unsigned i = 0; i < size; i++ )
+         freeList[i] = &entries[size - 1 - i];
+      freeCount      = size;
+   }
+
+   dynInstructPT alloc( const instructT& input ){
+      ASSERT( freeCount > 0, "Dynamic instruction pool exhausted (size=%u)", size );
+      dynInstructPT dInstP = freeList[--freeCount];
+      *dInstP        = dynInstructT(input);
+      live++;
+      if( live > peak ) peak = live;
+      return dInstP;
+   }
+
+   void release( dynInstructPT dInstP ){
+      ASSERT( freeCount < size, "Dynamic instruction pool overflown on release" );
+      freeList[freeCount++] = dInstP;
+      live--;
    }
 };
 
@@ -154,6 +564,15 @@ struct fpFileT{
    int            tag;
 };
 
+//Rename map (busy bits and tags) saved by fetch at a branch, to go back to
+//if the branch turns out mispredicted
+struct renameCkptT{
+   int            gprBusy[NUM_GP_REGISTERS];
+   int            gprTag[NUM_GP_REGISTERS];
+   int            fpBusy[NUM_FP_REGISTERS];
+   int            fpTag[NUM_FP_REGISTERS];
+};
+
 //Data structure for Reservation Station
 struct resStationT{
    dynInstructPT   dInstP;
@@ -168,8 +587,18 @@ struct resStationT{
    int             id;
 
    bool            inExec;
+   uint64_t        age;         // fetch order, used to keep ready lists oldest first
+
+   // Next station waiting on the same producer tag (for vj / vk)
+   resStationT*    jNext;
+   resStationT*    kNext;
+
+   // Neighbours in the ready list of the station's execution unit
+   resStationT*    readyNext;
+   resStationT*    readyPrev;
 
    resStationT(){
+      dInstP     = NULL;
       vjR        = true;
       vkR        = true;
       vj         = UNDEFINED;
@@ -180,20 +609,383 @@ struct resStationT{
       addr       = UNDEFINED;
 
       inExec     = false;
+      age        = 0;
+      jNext      = NULL;
+      kNext      = NULL;
+      readyNext  = NULL;
+      readyPrev  = NULL;
+   }
+
+};
+
+//Fixed-slot pool of reservation stations of one type
+//Slot index is the station id; busy slots are also chained in age order
+struct resStPoolT{
+   resStationT    *slots;
+   uint64_t       *freeMap;     // bit set => slot is free
+   int            *ageNext;
+   int            *agePrev;
+   int            head;         // oldest busy slot
+   int            tail;         // youngest busy slot
+   unsigned       size;
+   unsigned       count;
+   unsigned       words;
+
+   resStPoolT(){
+      slots          = NULL;
+      freeMap        = NULL;
+      ageNext        = NULL;
+      agePrev        = NULL;
+      size           = 0;
+      words          = 0;
+      clear();
+   }
+
+   ~resStPoolT(){
+      delete [] slots;
+      delete [] freeMap;
+      delete [] ageNext;
+      delete [] agePrev;
+   }
+
+   void init(unsigned size){
+      this->size     = size;
+      words          = (size + 63) / 64;
+      slots          = new resStationT[size];
+      freeMap        = new uint64_t[words > 0 ? words : 1];
+      ageNext        = new int[size > 0 ? size : 1];
+      agePrev        = new int[size > 0 ? size : 1];
+      clear();
+   }
+
+   // Marks every slot free
+   void clear(){
+      for( unsigned w = 0; w < words; w++ ){
+         unsigned bits = size - w * 64;
+         freeMap[w]    = bits >= 64 ? ~(uint64_t)0 : (((uint64_t)1 << bits) - 1);
+      }
+      head           = -1;
+      tail           = -1;
+      count          = 0;
+   }
+
+   bool isFull(){
+      return count == size;
+   }
+
+   // Takes the lowest free slot, resets it and appends it as the youngest station
+   resStationT* alloc(){
+      ASSERT( !isFull(), "Allocating from a full reservation station pool (size=%u)", size );
+      unsigned w     = 0;
+      while( freeMap[w] == 0 ) w++;
+      int id         = w * 64 + __builtin_ctzll(freeMap[w]);
+      freeMap[w]    &= ~((uint64_t)1 << (id % 64));
+
+      ageNext[id]    = -1;
+      agePrev[id]    = tail;
+      if( tail != -1 ) ageNext[tail] = id;
+      else             head          = id;
+      tail           = id;
+      count++;
+
+      slots[id]      = resStationT();
+      slots[id].id   = id;
+      return &slots[id];
+   }
+
+   void release(int id){
+      ASSERT( !isFree(id), "Releasing a free reservation station (id=%d)", id );
+      freeMap[id / 64] |= (uint64_t)1 << (id % 64);
+      if( agePrev[id] != -1 ) ageNext[agePrev[id]] = ageNext[id];
+      else                    head                 = ageNext[id];
+      if( ageNext[id] != -1 ) agePrev[ageNext[id]] = agePrev[id];
+      else                    tail                 = agePrev[id];
+      count--;
+   }
+
+   bool isFree(int id){
+      return (freeMap[id / 64] >> (id % 64)) & 1;
+   }
+};
+
+struct lsqEntryT{
+   unsigned       robTag;
+   bool           isStore;
+   bool           addrValid;
+   uint32_t       addr;
+   uint64_t       seq;          // age stamp, grows with program order
+   int            hashNext;     // resolved stores, same bucket, youngest first
+   int            hashPrev;
+   int            unkNext;      // stores with unknown address, oldest first
+   int            unkPrev;
+
+   // Loads only
+   bool           issued;       // sent to execution, addr is valid
+   bool           speculative;  // issued ahead of an older store with unknown address
+   uint64_t       srcSeq;       // seq + 1 of the store it read from, 0 for memory
+   int            depIdx;       // store it is predicted to depend on (-1: none)
+   uint64_t       depSeq;
+};
+
+//Load/store queue in program order
+//Stores with a known address are indexed by an address hash, stores with an
+//unknown address are chained in age order, so disambiguating a load does not
+//walk the ROB
+struct lsqT{
+   lsqEntryT      *entries;
+   int            *buckets;
+   unsigned       numBuckets;
+   int            head;
+   int            tail;
+   unsigned       count;
+   unsigned       size;
+   int            unkHead;      // oldest store with unknown address
+   int            unkTail;      // youngest store with unknown address
+   uint64_t       nextSeq;
+
+   lsqT(){
+      entries        = NULL;
+      buckets        = NULL;
+      numBuckets     = 0;
+      size           = 0;
+      clear();
+   }
+
+   ~lsqT(){
+      delete [] entries;
+      delete [] buckets;
+   }
+
+   void init(unsigned size){
+      this->size     = size;
+      numBuckets     = 1;
+      while( numBuckets < 2 * size ) numBuckets <<= 1;
+      entries        = new lsqEntryT[size > 0 ? size : 1];
+      buckets        = new int[numBuckets];
+      clear();
+   }
+
+   void clear(){
+      for( unsigned b = 0; b < numBuckets; b++ )
+         buckets[b]  = -1;
+      head           = 0;
+      tail           = 0;
+      count          = 0;
+      unkHead        = -1;
+      unkTail        = -1;
+      nextSeq        = 0;
+   }
+
+   bool isFull(){
+      return count == size;
+   }
+
+   unsigned bucketOf(uint32_t addr){
+      return (addr >> 2) & (numBuckets - 1);
+   }
+
+   // Appends a memory operation as the youngest entry, returns its slot
+   int push(unsigned robTag, bool isStore){
+      ASSERT( !isFull(), "Pushing into a full load/store queue (size=%u)", size );
+      int idx                = tail;
+      lsqEntryT* e           = &entries[idx];
+      e->robTag              = robTag;
+      e->isStore             = isStore;
+      e->addrValid           = false;
+      e->addr                = UNDEFINED;
+      e->seq                 = nextSeq++;
+      e->hashNext            = -1;
+      e->hashPrev            = -1;
+      e->unkNext             = -1;
+      e->unkPrev             = -1;
+      e->issued              = false;
+      e->speculative         = false;
+      e->srcSeq              = 0;
+      e->depIdx              = -1;
+      e->depSeq              = 0;
+      if( isStore ){
+         e->unkPrev          = unkTail;
+         if( unkTail != -1 ) entries[unkTail].unkNext = idx;
+         else                unkHead                  = idx;
+         unkTail             = idx;
+      }
+      tail                   = (tail + 1) % size;
+      count++;
+      return idx;
+   }
+
+   // Retires the oldest entry
+   void pop(){
+      ASSERT( count > 0, "Popping an empty load/store queue" );
+      lsqEntryT* e           = &entries[head];
+      if( e->isStore ){
+         if( e->addrValid ) unlinkHash(head);
+         else               unlinkUnknown(head);
+      }
+      head                   = (head + 1) % size;
+      count--;
+   }
+
+   // Records the address of a store and moves it into the address index
+   void resolve(int idx, uint32_t addr){
+      lsqEntryT* e           = &entries[idx];
+      if( !e->isStore || e->addrValid ) return;
+      unlinkUnknown(idx);
+      e->addrValid           = true;
+      e->addr                = addr;
+
+      // Keep the bucket chain youngest first
+      unsigned b             = bucketOf(addr);
+      int prev               = -1;
+      int cur                = buckets[b];
+      while( cur != -1 && entries[cur].seq > e->seq ){
+         prev                = cur;
+         cur                 = entries[cur].hashNext;
+      }
+      e->hashPrev            = prev;
+      e->hashNext            = cur;
+      if( prev != -1 ) entries[prev].hashNext = idx;
+      else             buckets[b]             = idx;
+      if( cur != -1 )  entries[cur].hashPrev  = idx;
+   }
+
+   // Youngest store older than slot idx whose address is unknown or equal
+   // to addr (-1 if none); that store alone decides whether the load waits
+   int youngestOlderStore(int idx, uint32_t addr){
+      uint64_t seq           = entries[idx].seq;
+      int best               = -1;
+      for( int s = unkTail; s != -1; s = entries[s].unkPrev ){
+         if( entries[s].seq < seq ){
+            best             = s;
+            break;
+         }
+      }
+      int match              = youngestOlderMatch(idx, addr);
+      if( match != -1 && (best == -1 || entries[match].seq > entries[best].seq) )
+         best                = match;
+      return best;
+   }
+
+   // Youngest store older than slot idx known to write addr (-1 if none)
+   int youngestOlderMatch(int idx, uint32_t addr){
+      uint64_t seq           = entries[idx].seq;
+      for( int s = buckets[bucketOf(addr)]; s != -1; s = entries[s].hashNext ){
+         if( entries[s].seq < seq && entries[s].addr == addr )
+            return s;
+      }
+      return -1;
+   }
+
+   // True if slot idx is in the queue and holds the entry stamped seq
+   bool holds(int idx, uint64_t seq){
+      return (unsigned)((idx - head + size) % size) < count && entries[idx].seq == seq;
+   }
+
+   // True if the load in slot idx is predicted to depend on a store whose address is still unknown
+   bool waitsOnStore(int idx){
+      lsqEntryT* e           = &entries[idx];
+      return e->depIdx != -1 && holds(e->depIdx, e->depSeq) && !entries[e->depIdx].addrValid;
    }
 
+   // Records a load leaving for execution: it reads the youngest older store to addr, or memory
+   void issueLoad(int idx, uint32_t addr, bool speculative){
+      lsqEntryT* e           = &entries[idx];
+      int src                = youngestOlderMatch(idx, addr);
+      e->issued              = true;
+      e->speculative         = speculative;
+      e->addr                = addr;
+      e->srcSeq              = src == -1 ? 0 : entries[src].seq + 1;
+   }
+
+   // Oldest load younger than the store in slot idx that went ahead of it and read
+   // the location the store writes from memory or an older store (-1 if none)
+   int violatedLoad(int idx){
+      lsqEntryT* st          = &entries[idx];
+      unsigned younger       = count - (idx - head + size) % size - 1;
+      for( unsigned n = 1; n <= younger; n++ ){
+         lsqEntryT* e        = &entries[(idx + n) % size];
+         if( !e->isStore && e->speculative && e->addr == st->addr && e->srcSeq <= st->seq )
+            return (idx + n) % size;
+      }
+      return -1;
+   }
+
+   // Drops the youngest entry, squashed before it retired
+   void popTail(){
+      ASSERT( count > 0, "Popping an empty load/store queue" );
+      tail                   = (tail + size - 1) % size;
+      lsqEntryT* e           = &entries[tail];
+      if( e->isStore ){
+         if( e->addrValid ) unlinkHash(tail);
+         else               unlinkUnknown(tail);
+      }
+      count--;
+   }
+
+   void unlinkHash(int idx){
+      lsqEntryT* e           = &entries[idx];
+      if( e->hashPrev != -1 ) entries[e->hashPrev].hashNext = e->hashNext;
+      else                    buckets[bucketOf(e->addr)]    = e->hashNext;
+      if( e->hashNext != -1 ) entries[e->hashNext].hashPrev = e->hashPrev;
+   }
+
+   void unlinkUnknown(int idx){
+      lsqEntryT* e           = &entries[idx];
+      if( e->unkPrev != -1 ) entries[e->unkPrev].unkNext = e->unkNext;
+      else                   unkHead                     = e->unkNext;
+      if( e->unkNext != -1 ) entries[e->unkNext].unkPrev = e->unkPrev;
+      else                   unkTail                     = e->unkPrev;
+   }
+};
+
+//Stations of one execution unit whose operands are all available, oldest first
+//Stations enter when their last operand arrives and leave when they are
+//selected, so select never looks at stations that are still waiting
+struct readyListT{
+   resStationT    *head;
+   resStationT    *tail;
+
+   readyListT(){
+      clear();
+   }
+
+   void clear(){
+      head           = NULL;
+      tail           = NULL;
+   }
+
+   void insert(resStationT* resP){
+      // Stations mostly become ready in fetch order, so search from the young end
+      resStationT* prev = tail;
+      while( prev != NULL && prev->age > resP->age )
+         prev           = prev->readyPrev;
+      resP->readyPrev   = prev;
+      resP->readyNext   = prev != NULL ? prev->readyNext : head;
+      if( resP->readyNext != NULL ) resP->readyNext->readyPrev = resP;
+      else                          tail                       = resP;
+      if( prev != NULL )            prev->readyNext            = resP;
+      else                          head                       = resP;
+   }
+
+   void remove(resStationT* resP){
+      if( resP->readyPrev != NULL ) resP->readyPrev->readyNext = resP->readyNext;
+      else                          head                       = resP->readyNext;
+      if( resP->readyNext != NULL ) resP->readyNext->readyPrev = resP->readyPrev;
+      else                          tail                       = resP->readyPrev;
+      resP->readyNext   = NULL;
+      resP->readyPrev   = NULL;
+   }
 };
 
 struct execWrLaneT{
    resStationT*   payloadP;
-   int            ttl;
-   bool           wr;
+   bool           busy;
    uint32_t       output;
    bool           outputReady;
 
    execWrLaneT(){
-      ttl            = 0;
-      wr             = false;
+      payloadP       = NULL;
+      busy           = false;
    }
 
 };
@@ -215,6 +1007,97 @@ struct execWrUnitT{
       this->numLanes += numLanes;
       this->latency   = latency;
       lanes           = (execWrLaneT*)realloc(lanes, this->numLanes * sizeof(execWrLaneT));
+      for( int i = this->numLanes - numLanes; i < this->numLanes; i++ )
+         lanes[i]     = execWrLaneT();
+   }
+};
+
+typedef enum {LANE_EXEC, LANE_OUTPUT, LANE_WR} lane_event_t;
+
+struct laneEventT{
+   exe_unit_t     unit;
+   int            lane;
+   lane_event_t   kind;
+};
+
+//Calendar of execution lane events, one bucket per upcoming cycle
+//A lane is only visited in the cycles where it starts executing, produces its
+//output and writes its result, never while it is just counting down
+struct laneWheelT{
+   laneEventT     *events;      // numBuckets rows of capacity events
+   unsigned       *counts;
+   unsigned       numBuckets;
+   unsigned       capacity;
+
+   laneWheelT(){
+      events         = NULL;
+      counts         = NULL;
+      numBuckets     = 0;
+      capacity       = 0;
+   }
+
+   ~laneWheelT(){
+      delete[] events;
+      delete[] counts;
+   }
+
+   // horizon: farthest cycle ahead an event is scheduled + 1
+   // capacity: total number of lanes (a lane has at most one event per cycle)
+   void init(unsigned horizon, unsigned capacity){
+      delete[] events;
+      delete[] counts;
+      numBuckets     = 1;
+      while( numBuckets < horizon ) numBuckets <<= 1;
+      this->capacity = capacity;
+      events         = new laneEventT[numBuckets * capacity];
+      counts         = new unsigned[numBuckets];
+      clear();
+   }
+
+   void clear(){
+      for( unsigned b = 0; b < numBuckets; b++ )
+         counts[b]   = 0;
+   }
+
+   void schedule(unsigned cycle, exe_unit_t unit, int lane, lane_event_t kind){
+      unsigned b     = cycle & (numBuckets - 1);
+      ASSERT( counts[b] < capacity, "Lane event bucket overflown (cycle=%u)", cycle );
+      laneEventT* e  = &events[b * capacity + counts[b]++];
+      e->unit        = unit;
+      e->lane        = lane;
+      e->kind        = kind;
+   }
+
+   laneEventT* bucket(unsigned cycle, unsigned& count){
+      unsigned b     = cycle & (numBuckets - 1);
+      count          = counts[b];
+      return &events[b * capacity];
+   }
+
+   void drain(unsigned cycle){
+      counts[cycle & (numBuckets - 1)] = 0;
+   }
+
+   // Drops the events still pending for a lane whose instruction got squashed
+   void cancel(exe_unit_t unit, int lane){
+      for( unsigned b = 0; b < numBuckets; b++ ){
+         laneEventT* row = &events[b * capacity];
+         unsigned keep  = 0;
+         for( unsigned i = 0; i < counts[b]; i++ ){
+            if( row[i].unit != unit || row[i].lane != lane )
+               row[keep++] = row[i];
+         }
+         counts[b]      = keep;
+      }
+   }
+
+   // Cycles from "cycle" to the next scheduled event (UNDEFINED if none)
+   unsigned nextEvent(unsigned cycle){
+      for( unsigned d = 0; d < numBuckets; d++ ){
+         if( counts[(cycle + d) & (numBuckets - 1)] > 0 )
+            return d;
+      }
+      return UNDEFINED;
    }
 };
 
@@ -225,14 +1108,23 @@ struct robT{
    unsigned        dest;
    unsigned        value;
    uint32_t        memLatency;
+   int             lsqIndex;     // load/store queue slot, -1 if not a memory op
 
+   // Consumer registry: stations waiting on this entry's result,
+   // filled at rename and drained at write result
+   resStationT*    jConsumers;
+   resStationT*    kConsumers;
 
    robT(){
       dInstP     = NULL;
       ready      = false;
+      misPred    = false;
       dest       = UNDEFINED;
       value      = UNDEFINED;
       memLatency = 0;
+      lsqIndex   = -1;
+      jConsumers = NULL;
+      kConsumers = NULL;
    }
 
    ~robT(){
@@ -279,40 +1171,684 @@ class Fifo {
 };
 
 
+//Data memory in 4 KB pages, allocated on first write: untouched pages read as
+//0xFF (the reset value). A two-level page table covers the 32-bit address space
+//(1024 directories of 1024 pages), so construction allocates only the top level.
+//Pages written since the last clear() are listed, so clear() costs O(pages dirtied).
+//Pages are carved from 64 KB slabs, keeping allocations out of most cycles.
+//Pages of a memory-mapped image point into the (private, copy-on-write) mapping
+#define MEM_PAGE_BITS 12
+#define MEM_PAGE_SIZE (1 << MEM_PAGE_BITS)
+#define MEM_DIR_BITS 10
+#define MEM_DIR_SIZE (1 << MEM_DIR_BITS)
+#define MEM_SLAB_PAGES 16
+
+struct memPageT{
+   unsigned char      *bytes;
+   bool               dirty;
+   bool               mapped;
+};
+
+//A file mapped with mmap, and the pages that point into it
+struct memImageT{
+   void               *base;
+   size_t             length;
+   memPageT           *pages;
+};
+
+struct pagedMemoryT{
+   memPageT           **dirs[MEM_DIR_SIZE];
+   vector<unsigned>   dirtyPages;
+   vector<memPageT*>  slabs;
+   vector<unsigned char*> slabBytes;
+   vector<memImageT>  images;
+   unsigned           allocated;
+
+   pagedMemoryT(){
+      memset( dirs, 0, sizeof(dirs) );
+      dirtyPages.reserve( MEM_SLAB_PAGES );
+      allocated        = 0;
+   }
+
+   ~pagedMemoryT(){
+      for(int d = 0; d < MEM_DIR_SIZE; d++)
+         delete [] dirs[d];
+      for(unsigned i = 0; i < slabs.size(); i++){
+         delete [] slabs[i];
+         delete [] slabBytes[i];
+      }
+      unmapImages();
+   }
+
+   // Page holding "address", NULL if it was never written
+   memPageT* peek(unsigned address){
+      memPageT **dir   = dirs[address >> (MEM_PAGE_BITS + MEM_DIR_BITS)];
+      return dir == NULL ? NULL : dir[(address >> MEM_PAGE_BITS) & (MEM_DIR_SIZE - 1)];
+   }
+
+   // Page table entry of "address", allocating its directory if needed
+   memPageT*& entry(unsigned address){
+      memPageT **&dir  = dirs[address >> (MEM_PAGE_BITS + MEM_DIR_BITS)];
+      if( dir == NULL ){
+         dir           = new memPageT*[MEM_DIR_SIZE];
+         memset( dir, 0, MEM_DIR_SIZE * sizeof(memPageT*) );
+      }
+      return dir[(address >> MEM_PAGE_BITS) & (MEM_DIR_SIZE - 1)];
+   }
+
+   void markDirty(memPageT *page, unsigned address){
+      if( !page->dirty ){
+         page->dirty   = true;
+         dirtyPages.push_back( address >> MEM_PAGE_BITS );
+      }
+   }
+
+   // Page holding "address", allocated if needed and marked dirty
+   memPageT* touch(unsigned address){
+      memPageT *&page  = entry(address);
+      if( page == NULL ){
+         if( allocated % MEM_SLAB_PAGES == 0 ){
+            slabs.push_back( new memPageT[MEM_SLAB_PAGES] );
+            slabBytes.push_back( new unsigned char[MEM_SLAB_PAGES * MEM_PAGE_SIZE] );
+         }
+         page          = &slabs.back()[allocated % MEM_SLAB_PAGES];
+         page->bytes   = slabBytes.back() + (allocated % MEM_SLAB_PAGES) * MEM_PAGE_SIZE;
+         memset( page->bytes, 0xFF, MEM_PAGE_SIZE );
+         page->dirty   = false;
+         page->mapped  = false;
+         allocated++;
+      }
+      markDirty( page, address );
+      return page;
+   }
+
+   unsigned char readByte(unsigned address){
+      memPageT *page   = peek(address);
+      return page == NULL ? 0xFF : page->bytes[address & (MEM_PAGE_SIZE - 1)];
+   }
+
+   // Aligned words never straddle a page
+   unsigned char* readWord(unsigned address){
+      static unsigned char untouched[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+      memPageT *page   = peek(address);
+      return page == NULL ? untouched : page->bytes + (address & (MEM_PAGE_SIZE - 1));
+   }
+
+   unsigned char* writeWord(unsigned address){
+      return touch(address)->bytes + (address & (MEM_PAGE_SIZE - 1));
+   }
+
+   void writeBytes(unsigned address, const unsigned char *bytes, unsigned len){
+      for(unsigned i = 0; i < len; ){
+         memPageT *page   = touch(address + i);
+         unsigned offset  = (address + i) & (MEM_PAGE_SIZE - 1);
+         unsigned n       = min( len - i, MEM_PAGE_SIZE - offset );
+         memcpy( page->bytes + offset, bytes + i, n );
+         i               += n;
+      }
+   }
+
+   // Takes over a private mapping of "length" bytes placed at the page-aligned "address":
+   // whole pages not yet written point into it, the others (and a partial last page) are copied
+   void map(unsigned address, void *base, size_t length){
+      memImageT image;
+      image.base       = base;
+      image.length     = length;
+      image.pages      = new memPageT[length / MEM_PAGE_SIZE];
+      unsigned char *bytes = (unsigned char*)base;
+      for(size_t i = 0; i < length; i += MEM_PAGE_SIZE){
+         unsigned n       = min( length - i, (size_t)MEM_PAGE_SIZE );
+         memPageT *&page  = entry(address + i);
+         if( page != NULL || n < MEM_PAGE_SIZE ){
+            writeBytes( address + i, bytes + i, n );
+            continue;
+         }
+         page             = &image.pages[i / MEM_PAGE_SIZE];
+         page->bytes      = bytes + i;
+         page->dirty      = false;
+         page->mapped     = true;
+         markDirty( page, address + i );
+      }
+      images.push_back( image );
+   }
+
+   void unmapImages(){
+      for(unsigned i = 0; i < images.size(); i++){
+         munmap( images[i].base, images[i].length );
+         delete [] images[i].pages;
+      }
+      images.clear();
+   }
+
+   // Back to all 0xFF; allocated pages stay for reuse, mapped ones are dropped
+   void clear(){
+      for(unsigned i = 0; i < dirtyPages.size(); i++){
+         memPageT *&page  = entry( dirtyPages[i] << MEM_PAGE_BITS );
+         if( page->mapped ){
+            page          = NULL;
+            continue;
+         }
+         memset( page->bytes, 0xFF, MEM_PAGE_SIZE );
+         page->dirty      = false;
+      }
+      dirtyPages.clear();
+      unmapImages();
+   }
+};
+
+//Formats text into a reusable buffer the way an ostream would, with the same
+//width/fill/base semantics, and writes it out in one call. It starts from the
+//stream's formatting state and leaves the stream in the state the equivalent
+//sequence of "<<" would have left it in, so output is byte-identical
+struct textRendererT{
+   string             buffer;
+   ios::fmtflags      basefield;
+   char               fill;
+   unsigned           width;
+   int                precision;
+
+   // false if "out" uses formatting flags that are not emulated here
+   bool begin(ostream& out){
+      ios::fmtflags plain = ios::basefield | ios::skipws | ios::unitbuf;
+      if( (out.flags() & ~plain) != 0 || out.width() != 0 )
+         return false;
+      basefield        = out.flags() & ios::basefield;
+      fill             = out.fill();
+      width            = 0;
+      precision        = out.precision();
+      buffer.clear();
+      return true;
+   }
+
+   void end(ostream& out){
+      out.write( buffer.data(), buffer.size() );
+      out.fill( fill );
+      out.setf( basefield, ios::basefield );
+   }
+
+   textRendererT& setw(unsigned n){ width = n; return *this; }
+   textRendererT& setfill(char c){ fill = c; return *this; }
+   textRendererT& hex(){ basefield = ios::hex; return *this; }
+   textRendererT& dec(){ basefield = ios::dec; return *this; }
+   textRendererT& endl(){ buffer += '\n'; return *this; }
+
+   textRendererT& put(const char *str, unsigned len){
+      if( width > len )
+         buffer.append( width - len, fill );
+      buffer.append( str, len );
+      width            = 0;
+      return *this;
+   }
+
+   textRendererT& put(const char *str){
+      return put( str, strlen(str) );
+   }
+
+   textRendererT& put(unsigned value){
+      char digits[12];
+      char *p          = digits + sizeof(digits);
+      unsigned radix   = basefield == ios::hex ? 16 : (basefield == ios::oct ? 8 : 10);
+      do{
+         *--p          = "0123456789abcdef"[value % radix];
+         value        /= radix;
+      } while( value );
+      return put( p, digits + sizeof(digits) - p );
+   }
+
+   textRendererT& put(int value){
+      if( value >= 0 || basefield == ios::hex || basefield == ios::oct )
+         return put( (unsigned)value );
+      char digits[12];
+      char *p          = digits + sizeof(digits);
+      unsigned magnitude = 0u - (unsigned)value;
+      do{
+         *--p          = '0' + magnitude % 10;
+         magnitude    /= 10;
+      } while( magnitude );
+      *--p             = '-';
+      return put( p, digits + sizeof(digits) - p );
+   }
+
+   textRendererT& put(float value){
+      char digits[64];
+      int len          = snprintf( digits, sizeof(digits), "%.*g", precision, (double)value );
+      return put( digits, len );
+   }
+};
+
+//Per-cycle counters: stall reasons of issue, dispatch and commit, busy execution
+//lanes and ROB/reservation station occupancy, summed over the cycles simulated
+struct perfCountersT{
+   unsigned       issueStalls[STALL_TOTAL];
+   unsigned       dispatchStalls[DISPATCH_STALL_TOTAL];
+   unsigned       commitStalls[COMMIT_STALL_TOTAL];
+   uint64_t       busyLanes[EX_TOTAL];
+   uint64_t       robOccupancy;
+   uint64_t       resStOccupancy[RS_TOTAL];
+
+   perfCountersT(){
+      clear();
+   }
+
+   void clear(){
+      memset( issueStalls, 0, sizeof(issueStalls) );
+      memset( dispatchStalls, 0, sizeof(dispatchStalls) );
+      memset( commitStalls, 0, sizeof(commitStalls) );
+      memset( busyLanes, 0, sizeof(busyLanes) );
+      memset( resStOccupancy, 0, sizeof(resStOccupancy) );
+      robOccupancy   = 0;
+   }
+
+   // Counts each reason set in "mask" (one bit per dispatch_stall_t) for "cycles" cycles
+   void dispatchStalled(unsigned mask, unsigned cycles){
+      for(int i = 0; i < DISPATCH_STALL_TOTAL; i++)
+         if( mask & (1 << i) )
+            dispatchStalls[i] += cycles;
+   }
+};
+
+#define STORE_SET_RESET (1024*1024) //memory instructions fetched between two clearings of the SSIT
+
+//Store-set memory dependence predictor. A load and a store that conflicted are put
+//in the same store set by the store set identifier table (SSIT, indexed by PC); the
+//last fetched store table (LFST) holds, per set, the last store of the set fetched,
+//and a load of the set fetched after it waits for that store's address. Sets merge
+//as conflicts are found and the SSIT is cleared now and then to forget stale ones
+struct storeSetT{
+   vector<int>        ssit;         // store set of a PC, -1 for none
+   vector<int>        lfstIdx;      // load/store queue slot of the last store of a set, -1 for none
+   vector<uint64_t>   lfstSeq;
+   unsigned           nextSet;
+   unsigned           fetched;
+
+   void init(unsigned ssit_bits, unsigned lfst_entries){
+      ssit.assign( 1u << ssit_bits, -1 );
+      lfstIdx.assign( lfst_entries, -1 );
+      lfstSeq.assign( lfst_entries, 0 );
+      nextSet          = 0;
+      fetched          = 0;
+   }
+
+   int& setOf(uint32_t pc){
+      return ssit[(pc >> 2) & (ssit.size() - 1)];
+   }
+
+   // Counts a fetched memory instruction, clearing the SSIT every STORE_SET_RESET
+   void tick(){
+      if( ++fetched % STORE_SET_RESET == 0 )
+         ssit.assign( ssit.size(), -1 );
+   }
+
+   // The load/store queue slots named by the LFST are gone once it is cleared
+   void flush(){
+      lfstIdx.assign( lfstIdx.size(), -1 );
+   }
+
+   // A store wrote where a younger load had read: put them in the same set
+   void train(uint32_t storePC, uint32_t loadPC){
+      int& storeSet    = setOf(storePC);
+      int& loadSet     = setOf(loadPC);
+      if( storeSet == -1 && loadSet == -1 ){
+         storeSet      = nextSet;
+         loadSet       = nextSet;
+         nextSet       = (nextSet + 1) % lfstIdx.size();
+      }
+      else if( storeSet == -1 )
+         storeSet      = loadSet;
+      else if( loadSet == -1 )
+         loadSet       = storeSet;
+      else{
+         int merged    = min(storeSet, loadSet);
+         storeSet      = merged;
+         loadSet       = merged;
+      }
+   }
+};
+
+//Entry of a tagged TAGE table
+struct tageEntryT{
+   uint16_t           tag;
+   int8_t             ctr;          // 3-bit signed counter, taken when >= 0
+   uint8_t            useful;       // 2-bit
+
+   tageEntryT(){
+      tag              = 0xFFFF;    // matches no tag
+      ctr              = 0;
+      useful           = 0;
+   }
+};
+
+struct btbEntryT{
+   uint32_t           pc;
+   uint32_t           target;
+};
+
+#define TAGE_TAG_BITS 8
+#define TAGE_USEFUL_AGING (256*1024) //updates between two halvings of the useful counters
+
+// Global history bits that index each tagged TAGE table
+const unsigned tage_history[TAGE_TABLES] = {4, 8, 16, 32};
+
+//Branch direction predictor and branch target buffer (BTB) of fetch. Fetch
+//shifts each guess into the global history; commit trains the tables with the
+//outcome and keeps the history of retired branches, which a squash goes back to.
+//- bimodal: 2-bit counters indexed by PC
+//- gshare: 2-bit counters indexed by PC xor global history
+//- TAGE: the bimodal counters as base predictor, overridden by the tagged table
+//  with the longest matching history; mispredictions allocate longer entries
+struct branchPredictorT{
+   predictor_t        type;
+   unsigned           indexBits;
+   vector<uint8_t>    counters;
+   vector<tageEntryT> tagged[TAGE_TABLES];
+   vector<btbEntryT>  btb;
+   uint64_t           history;
+   uint64_t           retiredHistory;
+   unsigned           updates;
+
+   void init(predictor_t kind, unsigned index_bits, unsigned btb_entries){
+      type             = kind;
+      indexBits        = index_bits;
+      counters.assign( 1u << indexBits, 1 );
+      for(int t = 0; t < TAGE_TABLES; t++)
+         tagged[t].assign( type == PREDICT_TAGE ? 1u << indexBits : 0, tageEntryT() );
+      btbEntryT empty  = { UNDEFINED, UNDEFINED };
+      btb.assign( btb_entries, empty );
+      history          = 0;
+      retiredHistory   = 0;
+      updates          = 0;
+   }
+
+   // Last "length" bits of the history folded by xor into "width" bits
+   static uint32_t fold(uint64_t bits, unsigned length, unsigned width){
+      if( length < 64 )
+         bits         &= ((uint64_t)1 << length) - 1;
+      uint32_t folded  = 0;
+      for( ; bits != 0; bits >>= width )
+         folded       ^= bits & ((1u << width) - 1);
+      return folded;
+   }
+
+   // Direction of the conditional branch at "pc"; "pred" keeps what train() needs
+   bool predict(uint32_t pc, branchPredT& pred){
+      uint32_t mask    = (1u << indexBits) - 1;
+      uint32_t line    = pc >> 2;
+      pred.index       = (type == PREDICT_GSHARE ? line ^ (uint32_t)history : line) & mask;
+      pred.taken       = counters[pred.index] >= 2;
+      pred.altTaken    = pred.taken;
+      pred.provider    = -1;
+      if( type == PREDICT_TAGE ){
+         for(int t = 0; t < TAGE_TABLES; t++){
+            pred.tagIndex[t] = (line ^ (line >> indexBits) ^ fold(history, tage_history[t], indexBits)) & mask;
+            pred.tag[t]      = (line ^ fold(history, tage_history[t], TAGE_TAG_BITS)
+                                     ^ (fold(history, tage_history[t], TAGE_TAG_BITS - 1) << 1)) & ((1u << TAGE_TAG_BITS) - 1);
+         }
+         // The longest matching history predicts, the next one is the alternate
+         for(int t = TAGE_TABLES - 1; t >= 0; t--){
+            const tageEntryT& entry = tagged[t][pred.tagIndex[t]];
+            if( entry.tag != pred.tag[t] )
+               continue;
+            if( pred.provider != -1 ){
+               pred.altTaken = entry.ctr >= 0;
+               break;
+            }
+            pred.provider  = t;
+            pred.taken     = entry.ctr >= 0;
+         }
+      }
+      history          = (history << 1) | pred.taken;
+      return pred.taken;
+   }
+
+   // Outcome of a retired conditional branch predicted by predict()
+   void train(const branchPredT& pred, bool taken){
+      retiredHistory   = (retiredHistory << 1) | taken;
+      if( pred.provider == -1 ){
+         uint8_t& ctr  = counters[pred.index];
+         ctr           = taken ? min(ctr + 1, 3) : max(ctr - 1, 0);
+      }
+      else{
+         tageEntryT& entry = tagged[pred.provider][pred.tagIndex[pred.provider]];
+         entry.ctr     = taken ? min(entry.ctr + 1, 3) : max(entry.ctr - 1, -4);
+         if( pred.taken != pred.altTaken )
+            entry.useful = pred.taken == taken ? min(entry.useful + 1, 3) : max(entry.useful - 1, 0);
+      }
+      if( type != PREDICT_TAGE )
+         return;
+
+      // A misprediction takes an entry not useful in a table of longer history,
+      // or makes them all less useful when there is none
+      if( pred.taken != taken ){
+         int t         = pred.provider + 1;
+         while( t < TAGE_TABLES && tagged[t][pred.tagIndex[t]].useful > 0 )
+            t++;
+         if( t < TAGE_TABLES ){
+            tageEntryT& entry = tagged[t][pred.tagIndex[t]];
+            entry.tag  = pred.tag[t];
+            entry.ctr  = taken ? 0 : -1;
+         }
+         else{
+            for(t = pred.provider + 1; t < TAGE_TABLES; t++)
+               tagged[t][pred.tagIndex[t]].useful--;
+         }
+      }
+      if( ++updates % TAGE_USEFUL_AGING == 0 ){
+         for(int t = 0; t < TAGE_TABLES; t++)
+            for(unsigned i = 0; i < tagged[t].size(); i++)
+               tagged[t][i].useful >>= 1;
+      }
+   }
+
+   // Target of the branch at "pc" if the BTB holds it
+   bool target(uint32_t pc, uint32_t& target){
+      const btbEntryT& entry = btb[(pc >> 2) & (btb.size() - 1)];
+      target           = entry.target;
+      return entry.pc == pc;
+   }
+
+   void setTarget(uint32_t pc, uint32_t target){
+      btbEntryT& entry = btb[(pc >> 2) & (btb.size() - 1)];
+      entry.pc         = pc;
+      entry.target     = target;
+   }
+
+   // Fetch restarts from the retired branches once the pipeline is flushed
+   void recover(){
+      history          = retiredHistory;
+   }
+
+   // Fetch resumes right after a mispredicted branch, with its outcome in the history
+   void repair(const branchPredT& pred, bool taken, bool conditional){
+      history          = conditional ? (pred.history << 1) | taken : pred.history;
+   }
+};
+
+//Outcomes of the instances of one branch instruction, counted at commit
+struct branchStatT{
+   unsigned       executed;
+   unsigned       taken;
+   unsigned       mispredicted;
+
+   branchStatT(){
+      executed       = 0;
+      taken          = 0;
+      mispredicted   = 0;
+   }
+};
+
+//Splits assembly source into tokens in place: no copies, no allocation
+struct asmLexerT{
+   const char         *pos;
+   const char         *end;
+   int                line;
+
+   asmLexerT(const char *source, size_t length){
+      pos              = source;
+      end              = source + length;
+      line             = 1;
+   }
+
+   static bool blank(char c){
+      return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+   }
+
+   void skipBlanks(){
+      while( pos < end && blank(*pos) )
+         pos++;
+   }
+
+   // Next blank-delimited token of the line, empty at its end
+   const char* token(unsigned& len){
+      skipBlanks();
+      const char *start = pos;
+      while( pos < end && *pos != '\n' && !blank(*pos) )
+         pos++;
+      len              = pos - start;
+      return start;
+   }
+
+   // Skips what is left of the line (extra tokens are ignored)
+   void nextLine(){
+      while( pos < end && *pos != '\n' )
+         pos++;
+      if( pos < end )
+         pos++;
+      line++;
+   }
+
+   // Register as R<n> or F<n>, optionally closed by ')'
+   void reg(uint32_t& reg, bool& regF, bool with_bracket=false){
+      skipBlanks();
+      ASSERT( pos < end && *pos != '\n', "Missing register at line %d", line );
+      regF             = *pos == 'F' || *pos == 'f';
+      pos++;
+      skipBlanks();
+      ASSERT( pos < end && *pos >= '0' && *pos <= '9', "Bad register at line %d", line );
+      reg              = 0;
+      while( pos < end && *pos >= '0' && *pos <= '9' )
+         reg           = reg * 10 + (*pos++ - '0');
+      ASSERT( reg < NUM_GP_REGISTERS, "Register out of range (=%u) at line %d", reg, line );
+      if( with_bracket ){
+         skipBlanks();
+         ASSERT( pos < end && *pos == ')', "Missing ')' at line %d", line );
+         pos++;
+      }
+   }
+
+   // Decimal or 0x-prefixed hexadecimal integer, falling back to strtod for
+   // anything else it accepts (fractions, exponents) so values match stod
+   uint32_t number(){
+      skipBlanks();
+      const char *start = pos;
+      bool negative    = pos < end && *pos == '-';
+      if( pos < end && (*pos == '-' || *pos == '+') )
+         pos++;
+      bool hex         = end - pos > 2 && pos[0] == '0' && (pos[1] == 'x' || pos[1] == 'X') && isxdigit(pos[2]);
+      if( hex )
+         pos          += 2;
+      const char *digits = pos;
+      int64_t value    = 0;
+      while( pos < end && (hex ? isxdigit(*pos) : isdigit(*pos)) && value < ((int64_t)1 << 40) ){
+         int digit     = isdigit(*pos) ? *pos - '0' : (*pos | 0x20) - 'a' + 10;
+         value         = value * (hex ? 16 : 10) + digit;
+         pos++;
+      }
+      ASSERT( pos > digits, "Bad immediate at line %d", line );
+      if( pos < end && (isalnum(*pos) || *pos == '.') ){
+         char *stop;
+         double exact  = strtod( start, &stop );
+         pos           = stop;
+         return (uint32_t)(int64_t)exact;
+      }
+      return (uint32_t)(negative ? -value : value);
+   }
+
+   // Offset of a memory operand: "<number>(", the register follows
+   uint32_t offset(){
+      uint32_t value   = number();
+      skipBlanks();
+      ASSERT( pos < end && *pos == '(', "Missing '(' at line %d", line );
+      pos++;
+      return value;
+   }
+};
+
 class sim_ooo{
 
    int            cycleCount;
    unsigned       PC;
 
-   instructPT     *instMemory;
+   vector<instructT> instMemory;
    int            instMemSize;
+   microOpT       *uops;
    int            instCount;
 
    gprFileT       gprFile[NUM_GP_REGISTERS];
    fpFileT        fpFile[NUM_FP_REGISTERS];
    execWrUnitT    execFp[EX_TOTAL];
+   laneWheelT     laneWheel;
 
    vector<execWrLaneT> bypassLane;
 
+   // Reservation stations freed by write result, released at the end of the cycle
+   vector<res_station_t> resGCUnit;
+   vector<int>           resGCIndex;
+
    unsigned       data_memory_size;
-   unsigned char  *data_memory;
+   pagedMemoryT   data_memory;
 
    unsigned       memLatency;
    unsigned       memFlag;
    unsigned       baseAddress;
 
-   vector <resStationT*>  resStation[RS_TOTAL];
+   resStPoolT     resStation[RS_TOTAL];
    unsigned       *resStSize;
+   readyListT     readyList[EX_TOTAL];
+   uint64_t       fetchSeq;
 
    unsigned       robSize;
    int            issueWidth;
+   int            commitWidth;
    bool           gSquash;
+   bool           earlyRecovery;
+   unsigned       recoverTag;
+   unsigned       earlyRecoveries;
+   vector<renameCkptT> renameCkpts;
+   bool           storeSetsOn;
+   storeSetT      storeSets;
+   unsigned       replayTag;
+   unsigned       speculativeLoads;
+   unsigned       memViolations;
+   unsigned       loadReplays;
    bool           memBlock;
+   bool           cycleSkipping;
+   unsigned       skippedCycles;
+   unsigned       functionalCount;
+   perfCountersT  counters;
+   textRendererT  text;
+   bool           fastPrint;
+   bool           programCache;
+   bool           programCached;
+
+   // Sampled simulation: period, warm-up and measured interval in instructions
+   unsigned       samplePeriod;
+   unsigned       sampleInterval;
+   unsigned       sampleWarmup;
+   unsigned       sampleCount;
+   double         sampleIPCMean;
+   double         sampleIPCM2;
    vector <instStatT> log;
+   bool           logMemory;
+   logSinkT       logSink;
+   traceWriterT   trace;
 
    //----------------------------------------------------------------------------//
 
    Fifo<robT> rob;
+   dynInstPoolT   dInstPool;
+   lsqT           lsq;
+   branchPredictorT predictor;
+   vector<branchStatT> branchStats;
    public:
 
    /* Instantiates the simulator
@@ -324,7 +1860,9 @@ class sim_ooo{
          unsigned num_add_res_stations,	// number of ADD reservation stations
          unsigned num_mul_res_stations, 	// number of MULT/DIV reservation stations
          unsigned num_load_buffers,	// number of LOAD buffers
-         unsigned issue_width=1		// issue width
+         unsigned issue_width=1,		// issue width
+         unsigned num_lsq_entries=0,	// number of load/store queue entries (0: same as ROB)
+         unsigned commit_width=1	// maximum number of instructions retired per clock cycle
          );	
 
    //de-allocates the simulator
@@ -342,6 +1880,12 @@ class sim_ooo{
    //runs the simulator for "cycles" clock cycles (run the program to completion if cycles=0) 
    void run(unsigned cycles=0);
 
+   //executes up to "instructions" instructions architecturally only (no timing), directly
+   //on registers and data memory, then leaves the pipeline empty for run() to continue
+   //from there; in-flight instructions are discarded and re-executed from the oldest one
+   //returns the number of instructions executed (fewer if EOP is reached)
+   unsigned fast_forward(unsigned instructions);
+
    //resets the state of the simulator
    /* Note: 
       - registers should be reset to UNDEFINED value 
@@ -377,12 +1921,141 @@ class sim_ooo{
    //returns the number of clock cycles 
    unsigned get_clock_cycles();
 
+   //returns the number of dynamic instruction records currently in use
+   unsigned get_dyn_inst_pool_live();
+
+   //returns the highest number of dynamic instruction records ever in use at once
+   unsigned get_dyn_inst_pool_peak();
+
+   //returns the number of loads and stores currently in the load/store queue
+   unsigned get_lsq_occupancy();
+
+   //enables/disables skipping over cycles in which only execution lanes and
+   //store commit latencies count down (on by default, results are unchanged);
+   //unrelated to the functional fast_forward()
+   void set_cycle_skipping(bool enable);
+
+   //returns the number of clock cycles skipped over by cycle skipping
+   unsigned get_skipped_cycles();
+
+   //returns the number of instructions executed by fast_forward() (not part of get_instructions_executed())
+   unsigned get_functional_instructions();
+
+   //returns the number of clock cycles in which issue stopped early because of "reason"
+   //(full ROB, full reservation stations or full load/store queue)
+   unsigned get_issue_stall_cycles(issue_stall_t reason);
+
+   //returns the number of data memory pages (4 KB) written or mapped since the last reset
+   unsigned get_dirty_memory_pages();
+
+   //returns the number of clock cycles in which ready reservation stations were held back
+   //from execution because of "reason" (busy lanes, memory lane blocked by a committing
+   //store, or a load waiting on an older store)
+   unsigned get_dispatch_stall_cycles(dispatch_stall_t reason);
+
+   //returns the number of clock cycles in which nothing committed because of "reason"
+   //(empty ROB, head still executing, or head store writing to memory)
+   unsigned get_commit_stall_cycles(commit_stall_t reason);
+
+   //returns the number of busy lanes of the given execution unit, summed over all clock cycles
+   uint64_t get_busy_lane_cycles(exe_unit_t exec_unit);
+
+   //returns the number of ROB entries in use, summed over all clock cycles
+   uint64_t get_rob_occupancy();
+
+   //returns the number of reservation stations of the given type in use, summed over all clock cycles
+   uint64_t get_res_station_occupancy(res_station_t res_station);
+
+   //prints the stall and utilization counters, as percentages of get_clock_cycles()
+   void print_counters();
+
+   //selects the branch predictor consulted by fetch (not-taken by default) with 2^index_bits
+   //entries per table and a direct-mapped BTB of btb_entries targets (a power of two);
+   //the predictor starts cold and is trained at commit; the pipeline must be empty
+   void set_branch_predictor(predictor_t type, unsigned index_bits=12, unsigned btb_entries=512);
+
+   //enables/disables recovering from a mispredicted branch as soon as it writes its result
+   //(off by default: the pipeline is squashed when the branch commits); fetch then saves the
+   //rename map at every branch, and a misprediction squashes only the younger instructions,
+   //restores the map and redirects fetch; the pipeline must be empty
+   void set_early_recovery(bool enable);
+
+   //returns the number of recoveries at write result, including those from branches that an
+   //older mispredicted branch squashed later
+   unsigned get_early_recoveries();
+
+   //enables/disables the store-set memory dependence predictor (off by default: a load waits
+   //for the address of every older store); with it, a load goes ahead of older stores with an
+   //unknown address unless it is predicted to depend on one of them; a store whose address
+   //then matches a younger load that already read the location trains the predictor and
+   //squashes the pipeline from the load, which is fetched again; the pipeline must be empty
+   // - ssit_bits: the store set identifier table has 2^ssit_bits entries
+   // - lfst_entries: number of store sets (last fetched store table entries)
+   void set_store_sets(bool enable, unsigned ssit_bits=10, unsigned lfst_entries=128);
+
+   //returns the number of loads that went to execution ahead of an older store with an unknown address
+   unsigned get_speculative_loads();
+
+   //returns the number of stores found to write a location a younger load had already read
+   unsigned get_memory_violations();
+
+   //returns the number of times the pipeline was squashed from a load to fetch it again
+   unsigned get_load_replays();
+
+   //returns the number of branches (jumps included) committed
+   unsigned get_branches();
+
+   //returns the number of committed branches that fetch mispredicted
+   unsigned get_branch_mispredictions();
+
+   //returns the fraction of the committed instances of the branch at "pc" that fetch predicted correctly
+   float get_branch_accuracy(unsigned pc);
+
+   //prints, for each branch that committed, its instances, taken ones, mispredictions and accuracy
+   void print_branch_stats();
+
+   //turns run() to completion into sampled simulation: every "period" instructions, the first
+   //ones are executed functionally, then "warmup" instructions run in detail unmeasured and
+   //the last "interval" instructions run in detail and are measured (period=0 turns it off)
+   void set_sampling(unsigned period, unsigned interval, unsigned warmup=0);
+
+   //returns the number of measured intervals of a sampled run
+   unsigned get_samples();
+
+   //returns the IPC estimated from the measured intervals
+   float get_sampled_IPC();
+
+   //returns the half-width of the 95% confidence interval of get_sampled_IPC()
+   float get_sampled_IPC_error();
+
+   //saves the state of the simulator in binary file "filename"
+   //- always: registers, data memory (only the parts that differ from the reset value), PC,
+   //  clock cycles and instructions executed
+   //- with microarchitectural=true: also ROB, reservation stations, execution lanes, load/store
+   //  queue and everything else in flight; otherwise the checkpoint resumes from the oldest
+   //  instruction that has not committed
+   //the program and the execution log are not part of a checkpoint
+   void save_checkpoint(const char *filename, bool microarchitectural=false);
+
+   //restores a checkpoint written by save_checkpoint() into a simulator built with the same
+   //configuration (memory size, ROB, reservation stations, load/store queue and execution units)
+   //and with the same program loaded
+   void restore_checkpoint(const char *filename);
+
    //prints the content of the data memory within the specified address range
    void print_memory(unsigned start_address, unsigned end_address);
 
    // writes an integer value to data memory at the specified address (use little-endian format: https://en.wikipedia.org/wiki/Endianness)
    void write_memory(unsigned address, unsigned value);
 
+   //loads the binary file "filename" in data memory at the specified address
+   //the file is mapped privately (copy-on-write) when base_address is page-aligned (4 KB),
+   //so large images load without copying and are shared through the page cache
+   void load_data_image(const char *filename, unsigned base_address=0x0);
+
+   //writes the content of the data memory within [start_address, end_address) to the binary file "filename"
+   void dump_memory_image(const char *filename, unsigned start_address, unsigned end_address);
+
    //prints the values of the registers 
    void print_registers();
 
@@ -398,24 +2071,101 @@ class sim_ooo{
    //print the content of the instruction window
    void print_pending_instructions();
 
+   //selects how print_status(), print_rob(), print_reservation_stations(), print_registers()
+   //and print_pending_instructions() format: through a reusable buffer written once per
+   //call (default), or field by field through cout; the output is the same
+   void set_fast_print(bool enable);
+
+   //enables caching decoded programs: load_program() then reads "<filename>.cache" when it was
+   //written from the same source text (same hash), and otherwise parses and (re)writes it
+   void set_program_cache(bool enable);
+
+   //returns true if the last load_program() was served from the program cache
+   bool get_program_cached();
+
    //print the whole execution history 
    void print_log();
-   instructT fetchInstruction ( unsigned pc ) ;
+
+   //preallocates room for "entries" records in the execution history, so
+   //that runs of known length never grow it
+   void reserve_log(unsigned entries);
+
+   //streams the execution history to binary file "filename" from now on, through a
+   //fixed-size buffer (NULL closes the file); print_log_file() turns it back into text
+   void set_log_file(const char *filename);
+
+   //enables/disables keeping the execution history in memory for print_log() (on by default)
+   void set_log_memory(bool enable);
+
+   //writes a pipeline trace for the Konata visualizer (Kanata format) to "filename" from
+   //now on: every instruction issued from then on with its stage transitions, commit or
+   //squash (NULL closes the file)
+   void set_trace_file(const char *filename);
+   void decodeProgram();
+   const microOpT& fetchMicroOp( unsigned pc );
+   const microOpT& uopOf( const instructT *inst );
    bool fetch();
+   uint32_t predictBranch(const instructT& instruct, branchPredT& pred);
+   void trainBranch(const instructT* inst, const branchPredT& pred, bool taken, uint32_t target);
+   void retireBranch(robT* robP);
    bool dispatch();
+   void operandsReady(resStationT* resP);
+   void recordStoreAddress(resStationT* resP);
+   void logInstruction(dynInstructPT dInstP);
+   void traceStage(dynInstructPT dInstP, stage_t stage);
+   void traceRetire(dynInstructPT dInstP, bool flushed);
+   unsigned dispatchHeld();
+   void renderRegisters();
+   void renderRob();
+   void renderReservationStations();
+   void renderPendingInstructions();
+   void streamRegisters();
+   void streamRob();
+   void streamReservationStations();
+   void streamPendingInstructions();
+   void sampleCounters(unsigned cycles);
    void predispatch();
-   bool isConflictingStore(int loadTag, unsigned memAddress, bool& bypassReady, uint32_t& bypassValue );
+   bool isConflictingStore(int loadTag, unsigned memAddress, bool& bypassReady, uint32_t& bypassValue, bool& speculative );
+   void predictDependence(int lsqIndex, const instructT& instruct);
+   void issueLoad(resStationT* resP, bool speculative);
+   void memoryViolation(int storeIdx, int loadIdx);
    bool issue() ;
    bool execute();
-   uint32_t aluGetOutput(dynInstructT* dInstP, unsigned src1V, unsigned src2V, uint32_t addr, bool& misPred);
+   static uint32_t exLoad(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken);
+   static uint32_t exAlu(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken);
+   static uint32_t exAluImm(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken);
+   static uint32_t exBltz(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken);
+   static uint32_t exBnez(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken);
+   static uint32_t exBeqz(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken);
+   static uint32_t exBgtz(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken);
+   static uint32_t exBgez(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken);
+   static uint32_t exBlez(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken);
+   static uint32_t exJump(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken);
+   static uint32_t exStore(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken);
+   static uint32_t exNone(sim_ooo *sim, const instructT *inst, unsigned src1V, unsigned src2V, uint32_t addr, bool& taken);
    bool writeResult(vector<res_station_t>& resGCUnit, vector<int>& resGCIndex);
    void wakeupAndRob(resStationT* resP, uint32_t output, vector<res_station_t>& resGCUnit, vector<int>& resGCIndex);
    void doExec(execWrLaneT* laneP, bool doWr);
    bool commit(int& popCount);
+   bool step(unsigned maxSkip, unsigned& elapsed);
+   bool runInstructions(unsigned instructions);
+   void runSampled();
+   bool fetchBlocked();
+   bool canSelect();
+   unsigned idleCycles();
+   void skipCycles(unsigned skip);
    void squash();
+   unsigned robDistance(unsigned tag);
+   void squashYounger(unsigned keep);
+   void recoverBranch(unsigned branchTag);
+   void replayLoad(unsigned loadTag);
+   void flushPipeline(bool record);
+   int stationToCode(resStationT* resP);
+   resStationT* codeToStation(int code);
+   int dInstToCode(dynInstructPT dInstP);
+   dynInstructPT codeToDInst(int code);
    bool regBusy(uint32_t regNo, bool isF) ;
    exe_unit_t opcodeToExUnit(opcode_t opcode);
-   int exLatency(opcode_t opcode) ;
    uint32_t agen (resStationT* resP) ;
    unsigned aluF (unsigned _value1, unsigned _value2, bool value1F, bool value2F, opcode_t opcode);
    unsigned alu (unsigned _value1, unsigned _value2, bool value1F, bool value2F, opcode_t opcode);
@@ -430,9 +2180,13 @@ class sim_ooo{
          map <string, int>& label_to_linenum,
          map <string, vector <int> >& unresolved_label_index,
          int line_num );
-   void getReg( istringstream& buff_iss, uint32_t& reg, bool& regF, bool with_brackets=false );
-   int parse( const string filename, unsigned base_address );
-   bool static resStSort( resStationT* a, resStationT* b ) { return a->id < b->id; };
+   int parse( const char *source, size_t length );
+   uint64_t programHash( const char *source, size_t length );
+   bool readProgramCache( const string& filename, uint64_t hash );
+   void writeProgramCache( const string& filename, uint64_t hash );
 };
 
+//prints an execution history written by sim_ooo::set_log_file() the way print_log() does
+void print_log_file(const char *filename);
+
 #endif /*SIM_OOO_H_*/
@@ -0,0 +1,265 @@
+#include "sweep.h"
+
+using namespace std;
+
+static const exe_unit_t sweep_units[EX_TOTAL] = { INTEGER, ADDER, MULTIPLIER, DIVIDER, MEMORY };
+
+// Parses a decimal or 0x-prefixed number, aborting on anything else
+static long long sweepNumber(const string& token){
+   char *end;
+   long long value          = strtoll( token.c_str(), &end, 0 );
+   ASSERT( !token.empty() && *end == '\0', "Bad number in sweep grid: %s", token.c_str() );
+   return value;
+}
+
+static float sweepFloat(const string& token){
+   char *end;
+   float value              = strtof( token.c_str(), &end );
+   ASSERT( !token.empty() && *end == '\0', "Bad number in sweep grid: %s", token.c_str() );
+   return value;
+}
+
+sweep::sweep(){
+   memorySize               = 1024*1024;
+
+   // Machine of the testcases
+   unsigned defaults[SWEEP_PARAMS] = { 6, 3, 2, 2, 2, 1, 0, 3, 2, 3, 2, 10, 1, 40, 1, 5, 1, 1 };
+   for(int i = 0; i < SWEEP_PARAMS; i++)
+      grid[i].assign( 1, defaults[i] );
+}
+
+void sweep::set_values(sweep_param_t param, const vector<unsigned>& values){
+   ASSERT( param < SWEEP_PARAMS, "Unknown sweep parameter (=%d)", param );
+   ASSERT( !values.empty(), "No values for sweep parameter %s", sweep_param_str[param].c_str() );
+   for(unsigned i = 0; i < values.size(); i++)
+      ASSERT( values[i] > 0 || param == SWEEP_LSQ, "Sweep parameter %s must be positive", sweep_param_str[param].c_str() );
+   grid[param]              = values;
+}
+
+void sweep::add_workload(const sweepWorkloadT& workload){
+   ASSERT( workload.name.find_first_of( ",\"" ) == string::npos, "Workload name must not contain ',' or '\"': %s", workload.name.c_str() );
+   workloads.push_back( workload );
+}
+
+void sweep::load_grid(const char *filename){
+   ifstream grid_h( filename, ifstream::in );
+   ASSERT( grid_h.is_open(), "Unable to open file: %s", filename );
+
+   string buff;
+   while( getline( grid_h, buff ) ){
+      buff                  = buff.substr( 0, buff.find( '#' ) );
+      istringstream buff_iss( buff );
+      string directive;
+      if( !(buff_iss >> directive) )
+         continue;
+
+      vector<string> args;
+      string arg;
+      while( buff_iss >> arg )
+         args.push_back( arg );
+
+      const string *paramP  = find( sweep_param_str, sweep_param_str + SWEEP_PARAMS, directive );
+      if( paramP != sweep_param_str + SWEEP_PARAMS ){
+         vector<unsigned> values;
+         for(unsigned i = 0; i < args.size(); i++)
+            values.push_back( sweepNumber( args[i] ) );
+         set_values( (sweep_param_t)(paramP - sweep_param_str), values );
+      }
+      else if( directive == "memory_size" ){
+         ASSERT( args.size() == 1, "memory_size takes one value" );
+         memorySize         = sweepNumber( args[0] );
+      }
+      else if( directive == "workload" ){
+         ASSERT( args.size() == 2 || args.size() == 3, "workload takes a name, a file and an optional base address" );
+         sweepWorkloadT workload;
+         workload.name        = args[0];
+         workload.filename    = args[1];
+         workload.baseAddress = args.size() == 3 ? sweepNumber( args[2] ) : 0;
+         add_workload( workload );
+      }
+      else{
+         ASSERT( !workloads.empty(), "%s before any workload", directive.c_str() );
+         sweepWorkloadT& workload = workloads.back();
+         if( directive == "int_register" ){
+            ASSERT( args.size() == 2, "int_register takes a register and a value" );
+            workload.intRegisters.push_back( make_pair( (unsigned)sweepNumber( args[0] ), (int)sweepNumber( args[1] ) ) );
+         }
+         else if( directive == "fp_register" ){
+            ASSERT( args.size() == 2, "fp_register takes a register and a value" );
+            workload.fpRegisters.push_back( make_pair( (unsigned)sweepNumber( args[0] ), sweepFloat( args[1] ) ) );
+         }
+         else if( directive == "memory" || directive == "fp_memory" ){
+            ASSERT( args.size() >= 2, "%s takes an address and one or more values", directive.c_str() );
+            unsigned address = sweepNumber( args[0] );
+            for(unsigned i = 1; i < args.size(); i++, address += 4){
+               unsigned word;
+               if( directive == "memory" )
+                  word      = sweepNumber( args[i] );
+               else{
+                  float value = sweepFloat( args[i] );
+                  memcpy( &word, &value, sizeof(word) );
+               }
+               workload.memory.push_back( make_pair( address, word ) );
+            }
+         }
+         else
+            ASSERT( false, "Unknown sweep directive: %s", directive.c_str() );
+      }
+   }
+}
+
+unsigned sweep::get_points(){
+   unsigned points          = workloads.size();
+   for(int i = 0; i < SWEEP_PARAMS; i++)
+      points               *= grid[i].size();
+   return points;
+}
+
+// Decodes a point number: workloads vary slowest, the last parameter fastest
+sweepPointT sweep::point(unsigned index){
+   sweepPointT pt;
+   for(int i = SWEEP_PARAMS - 1; i >= 0; i--){
+      pt.values[i]          = grid[i][index % grid[i].size()];
+      index                /= grid[i].size();
+   }
+   pt.workload              = index;
+   return pt;
+}
+
+sim_ooo *sweep::build(const sweepPointT& pt){
+   const unsigned *v        = pt.values;
+   sim_ooo *sim             = new sim_ooo( memorySize, v[SWEEP_ROB],
+                                           v[SWEEP_INT_RS], v[SWEEP_ADD_RS], v[SWEEP_MUL_RS], v[SWEEP_LOAD_RS],
+                                           v[SWEEP_ISSUE_WIDTH], v[SWEEP_LSQ], v[SWEEP_COMMIT_WIDTH] );
+   for(int i = 0; i < EX_TOTAL; i++)
+      sim->init_exec_unit( sweep_units[i], v[SWEEP_INT_LATENCY + 2*i], v[SWEEP_INT_UNITS + 2*i] );
+
+   const sweepWorkloadT& workload = workloads[pt.workload];
+   sim->load_program( workload.filename.c_str(), workload.baseAddress );
+   for(unsigned i = 0; i < workload.intRegisters.size(); i++)
+      sim->set_int_register( workload.intRegisters[i].first, workload.intRegisters[i].second );
+   for(unsigned i = 0; i < workload.fpRegisters.size(); i++)
+      sim->set_fp_register( workload.fpRegisters[i].first, workload.fpRegisters[i].second );
+   for(unsigned i = 0; i < workload.memory.size(); i++)
+      sim->write_memory( workload.memory[i].first, workload.memory[i].second );
+   return sim;
+}
+
+// Leading part of a results row, which identifies the point
+string sweep::key(const sweepPointT& pt, bool csv){
+   ostringstream out;
+   if( csv ){
+      out << workloads[pt.workload].name;
+      for(int i = 0; i < SWEEP_PARAMS; i++)
+         out << "," << pt.values[i];
+   }
+   else{
+      out << "{\"workload\": \"" << workloads[pt.workload].name << "\"";
+      for(int i = 0; i < SWEEP_PARAMS; i++)
+         out << ", \"" << sweep_param_str[i] << "\": " << pt.values[i];
+   }
+   return out.str();
+}
+
+// Header row of a CSV results file
+string sweep::columns(){
+   ostringstream out;
+   out << "workload";
+   for(int i = 0; i < SWEEP_PARAMS; i++)
+      out << "," << sweep_param_str[i];
+   out << ",cycles,instructions,ipc,stall_rob,stall_rs,stall_lsq";
+   return out.str();
+}
+
+// Keys of the rows already in the results file; a row cut short by an
+// interruption is dropped from the file so that its point runs again.
+// A CSV file written with other columns is not resumed
+set<string> sweep::recorded(const char *results, bool csv, bool& empty){
+   set<string> keys;
+   string content;
+   ifstream in( results, ifstream::in | ifstream::binary );
+   if( in.is_open() ){
+      ostringstream buff;
+      buff << in.rdbuf();
+      content               = buff.str();
+      in.close();
+   }
+
+   if( !content.empty() && content[content.size() - 1] != '\n' ){
+      content               = content.substr( 0, content.rfind( '\n' ) + 1 );
+      ofstream out( results, ofstream::out | ofstream::trunc | ofstream::binary );
+      ASSERT( out.is_open(), "Unable to open file: %s", results );
+      out << content;
+   }
+   empty                    = content.empty();
+
+   istringstream rows( content );
+   string row;
+   bool header              = csv;
+   while( getline( rows, row ) ){
+      if( header ){
+         ASSERT( row == columns(), "Results file %s has other columns than this sweep: %s", results, row.c_str() );
+         header             = false;
+         continue;
+      }
+      if( csv ){
+         size_t end         = 0;
+         for(int i = 0; i <= SWEEP_PARAMS && end != string::npos; i++)
+            end             = row.find( ',', end + (i > 0) );
+         if( end != string::npos )
+            keys.insert( row.substr( 0, end ) );
+      }
+      else{
+         size_t end         = row.find( ", \"cycles\"" );
+         if( end != string::npos )
+            keys.insert( row.substr( 0, end ) );
+      }
+   }
+   return keys;
+}
+
+unsigned sweep::run(const char *results, unsigned threads){
+   ASSERT( !workloads.empty(), "Sweep without workloads" );
+
+   string name              = results;
+   bool csv                 = name.size() >= 4 && name.compare( name.size() - 4, 4, ".csv" ) == 0;
+   bool empty;
+   set<string> done         = recorded( results, csv, empty );
+
+   ofstream out( results, ofstream::out | ofstream::app | ofstream::binary );
+   ASSERT( out.is_open(), "Unable to open file: %s", results );
+   if( csv && empty )
+      out << columns() << endl;
+
+   vector<sweepPointT> pending;
+   batch_runner runner( threads );
+   unsigned points          = get_points();
+   for(unsigned i = 0; i < points; i++){
+      sweepPointT pt        = point(i);
+      if( done.count( key(pt, csv) ) )
+         continue;
+      pending.push_back( pt );
+      runner.add_job( [this, pt]() { return build(pt); } );
+   }
+
+   // Rows are written as points finish, so an interrupted sweep keeps what it did
+   mutex outLock;
+   runner.set_on_done( [&](unsigned job, const batchResultT& result, sim_ooo* sim) {
+      ostringstream row;
+      row << key( pending[job], csv );
+      if( csv )
+         row << "," << result.cycles << "," << result.instructions << "," << result.IPC
+             << "," << sim->get_issue_stall_cycles(STALL_ROB) << "," << sim->get_issue_stall_cycles(STALL_RS)
+             << "," << sim->get_issue_stall_cycles(STALL_LSQ);
+      else
+         row << ", \"cycles\": " << result.cycles << ", \"instructions\": " << result.instructions
+             << ", \"ipc\": " << result.IPC << ", \"stall_rob\": " << sim->get_issue_stall_cycles(STALL_ROB)
+             << ", \"stall_rs\": " << sim->get_issue_stall_cycles(STALL_RS)
+             << ", \"stall_lsq\": " << sim->get_issue_stall_cycles(STALL_LSQ) << "}";
+      lock_guard<mutex> guard( outLock );
+      out << row.str() << endl;
+   } );
+   runner.run();
+
+   return pending.size();
+}
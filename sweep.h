@@ -0,0 +1,79 @@
+#ifndef SWEEP_H_
+#define SWEEP_H_
+
+#include "sim_ooo.h"
+#include "batch_runner.h"
+#include <set>
+
+using namespace std;
+
+// Swept parameters, in the order of the results columns; new parameters go last
+// so that the columns of existing results files keep their place
+typedef enum {SWEEP_ROB, SWEEP_INT_RS, SWEEP_ADD_RS, SWEEP_MUL_RS, SWEEP_LOAD_RS, SWEEP_ISSUE_WIDTH, SWEEP_LSQ,
+              SWEEP_INT_LATENCY, SWEEP_INT_UNITS, SWEEP_ADD_LATENCY, SWEEP_ADD_UNITS, SWEEP_MUL_LATENCY, SWEEP_MUL_UNITS,
+              SWEEP_DIV_LATENCY, SWEEP_DIV_UNITS, SWEEP_MEM_LATENCY, SWEEP_MEM_UNITS, SWEEP_COMMIT_WIDTH, SWEEP_PARAMS} sweep_param_t;
+
+const string sweep_param_str[] = {"rob", "int_rs", "add_rs", "mul_rs", "load_rs", "issue_width", "lsq",
+                                  "int_latency", "int_units", "add_latency", "add_units", "mul_latency", "mul_units",
+                                  "div_latency", "div_units", "mem_latency", "mem_units", "commit_width"};
+
+// A program together with the registers and data memory it starts from
+struct sweepWorkloadT{
+   string                          name;
+   string                          filename;
+   unsigned                        baseAddress;
+   vector< pair<unsigned, int> >   intRegisters;
+   vector< pair<unsigned, float> > fpRegisters;
+   vector< pair<unsigned, unsigned> > memory;
+};
+
+struct sweepPointT{
+   unsigned       workload;
+   unsigned       values[SWEEP_PARAMS];
+};
+
+class sweep{
+
+   unsigned                memorySize;
+   vector<unsigned>        grid[SWEEP_PARAMS];
+   vector<sweepWorkloadT>  workloads;
+
+   public:
+
+   // instantiates a sweep over a single point: the configuration of the testcases
+   sweep();
+
+   // reads the parameter grid and the workloads from a text file, one directive per line:
+   // - <parameter> <value>...: values swept for a parameter (see sweep_param_str)
+   // - memory_size <bytes>: data memory size of every point
+   // - workload <name> <asm file> [base address]: adds a workload, set up by the lines that follow:
+   //   int_register <reg> <value>, fp_register <reg> <value>,
+   //   memory <address> <word>..., fp_memory <address> <float>... (consecutive words)
+   // '#' starts a comment; numbers may be decimal or 0x-prefixed hexadecimal
+   void load_grid(const char *filename);
+
+   // sets the values swept for a parameter
+   void set_values(sweep_param_t param, const vector<unsigned>& values);
+
+   // adds a workload
+   void add_workload(const sweepWorkloadT& workload);
+
+   //returns the number of points (workloads x parameter combinations)
+   unsigned get_points();
+
+   // simulates every point not yet recorded in "results" on "threads" threads (0: one per host core)
+   // and appends one row per point as it finishes: CSV if the file name ends in .csv, JSON lines otherwise
+   // aborts if an existing CSV file has other columns than this sweep
+   // returns the number of points simulated
+   unsigned run(const char *results, unsigned threads=0);
+
+   private:
+
+   sweepPointT point(unsigned index);
+   sim_ooo *build(const sweepPointT& pt);
+   string key(const sweepPointT& pt, bool csv);
+   string columns();
+   set<string> recorded(const char *results, bool csv, bool& empty);
+};
+
+#endif /*SWEEP_H_*/
@@ -0,0 +1,22 @@
+#include "sweep.h"
+
+using namespace std;
+
+// Design-space sweep: simulates every combination of a parameter grid and a list of workloads
+// usage: sweep <grid file> <results file (.csv or .json)> [threads]
+int main(int argc, char **argv){
+   if( argc < 3 || argc > 4 ){
+      cerr << "usage: " << argv[0] << " <grid file> <results file (.csv or .json)> [threads]" << endl;
+      return 1;
+   }
+
+   sweep design;
+   design.load_grid( argv[1] );
+   unsigned threads         = argc == 4 ? atoi( argv[3] ) : 0;
+   unsigned points          = design.get_points();
+   unsigned simulated       = design.run( argv[2], threads );
+
+   cout << "Points = " << points << ", simulated = " << simulated
+        << ", already recorded = " << points - simulated << endl;
+   return 0;
+}
@@ -0,0 +1,99 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+#include <new>
+
+using namespace std;
+
+/* Test case for steady-state heap allocations of the simulator cycle loop */ 
+/* DO NOT MODIFY */
+
+/* counts every call to the global operator new */
+static unsigned long allocations = 0;
+
+void* operator new(size_t size){
+	allocations++;
+	void *p = malloc(size ? size : 1);
+	if (p == NULL) throw bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size){
+	return operator new(size);
+}
+
+void operator delete(void *p) noexcept{
+	free(p);
+}
+
+void operator delete[](void *p) noexcept{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept{
+	free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept{
+	free(p);
+}
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+int main(int argc, char **argv){
+
+	unsigned i;
+
+	// instantiates sim_ooo with a 1MB data memory
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   16,          //rob size
+				   4, 4, 4, 4,  //int, add, mult, load reservation stations
+				   2); 		//issue width
+			
+	//initialize execution units
+        ooo->init_exec_unit(INTEGER, 2, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 5, 1);
+
+	//loads program in instruction memory at address 0x00000000
+	ooo->load_program("asm/stream.asm", 0x00000000);
+
+	//initialize data memory
+	for (i = 0; i < 2001; i++) ooo->write_memory(0xA000 + 4*i, float2unsigned((float)i));
+
+	// the execution log is the only structure that grows with the run
+	ooo->reserve_log(100000);
+
+	// warm-up: first 1000 clock cycles
+	ooo->run(1000);
+
+	// steady state: count heap allocations over the next 100000 clock cycles
+	unsigned long before = allocations;
+	ooo->run(100000);
+	unsigned long steady = allocations - before;
+
+	cout << "Heap allocations during steady-state cycles = " << dec << steady << endl;
+
+	// runs program to completion
+	ooo->run(); 
+
+	cout << "PROGRAM TERMINATED\n";
+	cout << "===================" << endl << endl;
+
+	ooo->print_registers();
+	ooo->print_memory(0xC000, 0xC020);
+	cout << endl;
+
+	cout << "Peak dynamic instructions in flight = " << dec << ooo->get_dyn_inst_pool_peak() << endl;
+	cout << "Instruction executed = " << dec << ooo->get_instructions_executed() << endl;
+	cout << "Clock cycles = " << dec << ooo->get_clock_cycles() << endl;
+	cout << "IPC = " << dec << ooo->get_IPC() << endl;
+}
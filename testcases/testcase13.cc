@@ -0,0 +1,77 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+using namespace std;
+
+/* Test case for idle-cycle skipping: must match cycle-by-cycle stepping */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+/* runs the streaming kernel and returns everything it prints */
+string simulate(bool cycle_skipping, unsigned &cycles, unsigned &skipped){
+
+	unsigned i;
+
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   8,           //rob size
+				   2, 2, 2, 2,  //int, add, mult, load reservation stations
+				   1); 		//issue width
+			
+	//initialize execution units
+        ooo->init_exec_unit(INTEGER, 2, 1);
+        ooo->init_exec_unit(ADDER, 3, 1);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 5, 1);
+
+	ooo->set_cycle_skipping(cycle_skipping);
+
+	//loads program in instruction memory at address 0x00000000
+	ooo->load_program("asm/stream.asm", 0x00000000);
+
+	//initialize data memory
+	for (i = 0; i < 2001; i++) ooo->write_memory(0xA000 + 4*i, float2unsigned((float)i));
+
+	stringstream out;
+	streambuf *coutbuf = cout.rdbuf(out.rdbuf());
+
+	// a few bounded steps first, then run to completion
+	for (i = 0; i < 10; i++){
+		ooo->run(37);
+		ooo->print_status();
+	}
+	ooo->run(); 
+
+	ooo->print_registers();
+	ooo->print_memory(0xC000, 0xC020);
+	ooo->print_log();
+
+	cout.rdbuf(coutbuf);
+
+	cycles = ooo->get_clock_cycles();
+	skipped = ooo->get_skipped_cycles();
+	delete ooo;
+	return out.str();
+}
+
+int main(int argc, char **argv){
+
+	unsigned stepCycles, stepSkipped, skipCycles, skipSkipped;
+
+	string stepped = simulate(false, stepCycles, stepSkipped);
+	string skipped = simulate(true, skipCycles, skipSkipped);
+
+	cout << "Clock cycles (cycle-by-cycle) = " << dec << stepCycles << endl;
+	cout << "Clock cycles (cycle skipping) = " << dec << skipCycles << endl;
+	cout << "Skipped cycles without cycle skipping = " << dec << stepSkipped << endl;
+	cout << "Cycle skipping skipped some cycles = " << (skipSkipped > 0 ? "yes" : "no") << endl;
+	cout << "Output identical = " << (stepped == skipped ? "yes" : "no") << endl;
+}
@@ -0,0 +1,84 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+using namespace std;
+
+/* Test case for functional fast-forward followed by detailed simulation */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+sim_ooo *build(){
+	// instantiates sim_ooo with a 1MB data memory
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   6,           //rob size
+				   3, 2, 2, 2,  //int, add, mult, load reservation stations
+				   2); 		//issue width
+			
+	//initialize execution units
+        ooo->init_exec_unit(INTEGER, 3, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 5, 1);
+
+	//loads program in instruction memory at address 0x00000000
+	ooo->load_program("asm/sort.asm", 0x00000000);
+
+	//initialize general purpose registers
+	ooo->set_int_register(7, 0x80000000);
+
+        //initialize data memory 
+	unsigned i, j;
+        for (i = 0xA000, j=12; i<0xA030; i+=4, j-=1) ooo->write_memory(i,float2unsigned((float)(j)));
+	return ooo;
+}
+
+/* architectural state: registers and the sorted array */
+string state(sim_ooo *ooo){
+	stringstream out;
+	streambuf *coutbuf = cout.rdbuf(out.rdbuf());
+	ooo->print_registers();
+	ooo->print_memory(0xB000, 0xB030);
+	cout.rdbuf(coutbuf);
+	return out.str();
+}
+
+int main(int argc, char **argv){
+
+	// reference: detailed simulation only
+	sim_ooo *detailed = build();
+	detailed->run();
+
+	// functional fast-forward from the start, then detailed
+	sim_ooo *fromStart = build();
+	unsigned ff1 = fromStart->fast_forward(300);
+	fromStart->run();
+
+	// detailed, functional hand-off with instructions in flight, detailed again
+	sim_ooo *midRun = build();
+	midRun->run(101);
+	unsigned ff2 = midRun->fast_forward(200);
+	midRun->run();
+
+	cout << "PROGRAM TERMINATED\n";
+	cout << "===================" << endl << endl;
+
+	cout << state(fromStart) << endl;
+
+	cout << "Fast-forwarded instructions (from start) = " << dec << ff1 << " / " << fromStart->get_functional_instructions() << endl;
+	cout << "Fast-forwarded instructions (mid run) = " << dec << ff2 << " / " << midRun->get_functional_instructions() << endl;
+	cout << "Detailed instructions (reference) = " << dec << detailed->get_instructions_executed() << endl;
+	cout << "Detailed instructions (from start) = " << dec << fromStart->get_instructions_executed() << endl;
+	cout << "Fast-forward from start matches detailed = " << (state(fromStart) == state(detailed) ? "yes" : "no") << endl;
+	cout << "Fast-forward mid run matches detailed = " << (state(midRun) == state(detailed) ? "yes" : "no") << endl;
+	cout << "Clock cycles (from start) = " << dec << fromStart->get_clock_cycles() << endl;
+	cout << "IPC (from start) = " << dec << fromStart->get_IPC() << endl;
+}
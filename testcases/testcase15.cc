@@ -0,0 +1,67 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+using namespace std;
+
+/* Test case for sampled simulation with an IPC confidence interval */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+sim_ooo *build(){
+	// instantiates sim_ooo with a 1MB data memory
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   16,          //rob size
+				   4, 4, 4, 4,  //int, add, mult, load reservation stations
+				   2); 		//issue width
+			
+	//initialize execution units
+        ooo->init_exec_unit(INTEGER, 2, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 5, 1);
+
+	//loads program in instruction memory at address 0x00000000
+	ooo->load_program("asm/stream.asm", 0x00000000);
+
+	//initialize data memory
+	for (unsigned i = 0; i < 2001; i++) ooo->write_memory(0xA000 + 4*i, float2unsigned((float)i));
+	return ooo;
+}
+
+int main(int argc, char **argv){
+
+	// reference: every instruction in detail
+	sim_ooo *detailed = build();
+	detailed->run();
+
+	// every 1250 instructions: 1050 functional, 100 warm-up, 100 measured
+	sim_ooo *sampled = build();
+	sampled->set_sampling(1250, 100, 100);
+	sampled->run();
+
+	cout << "PROGRAM TERMINATED\n";
+	cout << "===================" << endl << endl;
+
+	sampled->print_registers();
+	sampled->print_memory(0xC000, 0xC020);
+	cout << endl;
+
+	cout << "Instruction executed (detailed run) = " << dec << detailed->get_instructions_executed() << endl;
+	cout << "Clock cycles (detailed run) = " << dec << detailed->get_clock_cycles() << endl;
+	cout << "IPC (detailed run) = " << dec << detailed->get_IPC() << endl << endl;
+
+	cout << "Instruction executed in detail (sampled run) = " << dec << sampled->get_instructions_executed() << endl;
+	cout << "Instruction executed functionally (sampled run) = " << dec << sampled->get_functional_instructions() << endl;
+	cout << "Clock cycles (sampled run) = " << dec << sampled->get_clock_cycles() << endl;
+	cout << "Samples = " << dec << sampled->get_samples() << endl;
+	cout << "Sampled IPC = " << dec << sampled->get_sampled_IPC() << " +/- " << sampled->get_sampled_IPC_error() << " (95% confidence)" << endl;
+}
@@ -0,0 +1,109 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+#include <stdio.h>
+
+using namespace std;
+
+/* Test case for checkpoint save/restore */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+sim_ooo *build(){
+	// instantiates sim_ooo with a 1MB data memory
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   6,           //rob size
+				   3, 2, 2, 2,  //int, add, mult, load reservation stations
+				   2); 		//issue width
+			
+	//initialize execution units
+        ooo->init_exec_unit(INTEGER, 3, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 5, 1);
+
+	//loads program in instruction memory at address 0x00000000
+	ooo->load_program("asm/sort.asm", 0x00000000);
+
+	//initialize general purpose registers
+	ooo->set_int_register(7, 0x80000000);
+
+        //initialize data memory 
+	unsigned i, j;
+        for (i = 0xA000, j=12; i<0xA030; i+=4, j-=1) ooo->write_memory(i,float2unsigned((float)(j)));
+	return ooo;
+}
+
+/* architectural state: registers and the sorted array */
+string state(sim_ooo *ooo){
+	stringstream out;
+	streambuf *coutbuf = cout.rdbuf(out.rdbuf());
+	ooo->print_registers();
+	ooo->print_memory(0xB000, 0xB030);
+	cout.rdbuf(coutbuf);
+	return out.str();
+}
+
+/* stall and utilization counters */
+string counters(sim_ooo *ooo){
+	stringstream out;
+	streambuf *coutbuf = cout.rdbuf(out.rdbuf());
+	ooo->print_counters();
+	cout.rdbuf(coutbuf);
+	return out.str();
+}
+
+int main(int argc, char **argv){
+
+	// reference: uninterrupted detailed simulation
+	sim_ooo *detailed = build();
+	detailed->run();
+
+	// microarchitectural checkpoint with instructions in flight, resumed in a fresh instance
+	sim_ooo *saver = build();
+	saver->run(101);
+	saver->save_checkpoint("testcase16_micro.ckpt", true);
+	saver->save_checkpoint("testcase16_arch.ckpt");
+	saver->run();
+
+	sim_ooo *micro = build();
+	micro->restore_checkpoint("testcase16_micro.ckpt");
+	micro->run();
+
+	// architectural checkpoint: the pipeline refills from the oldest uncommitted instruction
+	sim_ooo *arch = build();
+	arch->restore_checkpoint("testcase16_arch.ckpt");
+	arch->run();
+
+	// roll the finished simulator back and run the tail again
+	saver->restore_checkpoint("testcase16_micro.ckpt");
+	saver->run();
+
+	remove("testcase16_micro.ckpt");
+	remove("testcase16_arch.ckpt");
+
+	cout << "PROGRAM TERMINATED\n";
+	cout << "===================" << endl << endl;
+
+	cout << state(micro) << endl;
+
+	cout << "Microarchitectural restore matches detailed = " << (state(micro) == state(detailed) ? "yes" : "no") << endl;
+	cout << "Architectural restore matches detailed = " << (state(arch) == state(detailed) ? "yes" : "no") << endl;
+	cout << "Rollback matches detailed = " << (state(saver) == state(detailed) ? "yes" : "no") << endl;
+	cout << "Counters (microarchitectural restore) match detailed = " << (counters(micro) == counters(detailed) ? "yes" : "no") << endl;
+	cout << "Counters (rollback) match detailed = " << (counters(saver) == counters(detailed) ? "yes" : "no") << endl;
+	cout << "Clock cycles (reference) = " << dec << detailed->get_clock_cycles() << endl;
+	cout << "Clock cycles (microarchitectural restore) = " << dec << micro->get_clock_cycles() << endl;
+	cout << "Clock cycles (rollback) = " << dec << saver->get_clock_cycles() << endl;
+	cout << "Clock cycles (architectural restore) = " << dec << arch->get_clock_cycles() << endl;
+	cout << "Instructions (microarchitectural restore) = " << dec << micro->get_instructions_executed() << endl;
+	cout << "Instructions (architectural restore) = " << dec << arch->get_instructions_executed() << endl;
+}
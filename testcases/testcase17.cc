@@ -0,0 +1,72 @@
+#include "sim_ooo.h"
+#include "batch_runner.h"
+#include <iostream>
+#include <stdlib.h>
+
+using namespace std;
+
+/* Test case for the parallel batch runner */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+/* sort on a machine of the given ROB size and issue width */
+sim_ooo *build(unsigned rob_size, unsigned issue_width){
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   rob_size,    //rob size
+				   3, 2, 2, 2,  //int, add, mult, load reservation stations
+				   issue_width);//issue width
+			
+	//initialize execution units
+        ooo->init_exec_unit(INTEGER, 3, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 5, 1);
+
+	//loads program in instruction memory at address 0x00000000
+	ooo->load_program("asm/sort.asm", 0x00000000);
+
+	//initialize general purpose registers
+	ooo->set_int_register(7, 0x80000000);
+
+        //initialize data memory 
+	unsigned i, j;
+        for (i = 0xA000, j=12; i<0xA030; i+=4, j-=1) ooo->write_memory(i,float2unsigned((float)(j)));
+	return ooo;
+}
+
+int main(int argc, char **argv){
+
+	batch_runner runner(4);
+	for (unsigned rob = 2; rob <= 16; rob *= 2)
+		for (unsigned width = 1; width <= 3; width++)
+			runner.add_job([=]() { return build(rob, width); });
+	runner.run();
+
+	// the same configurations one after the other
+	bool match = true;
+	unsigned job = 0;
+	for (unsigned rob = 2; rob <= 16; rob *= 2)
+		for (unsigned width = 1; width <= 3; width++, job++) {
+			sim_ooo *ooo = build(rob, width);
+			ooo->run();
+			batchResultT result = runner.get_result(job);
+			match &= result.cycles == ooo->get_clock_cycles() && result.instructions == ooo->get_instructions_executed();
+			cout << "ROB " << dec << rob << " width " << width << ": cycles = " << result.cycles 
+			     << ", instructions = " << result.instructions << ", IPC = " << result.IPC << endl;
+			delete ooo;
+		}
+
+	cout << endl;
+	cout << "Jobs = " << dec << runner.get_jobs() << endl;
+	cout << "Total clock cycles = " << dec << runner.get_total_cycles() << endl;
+	cout << "Total instructions = " << dec << runner.get_total_instructions() << endl;
+	cout << "Mean IPC = " << dec << runner.get_mean_IPC() << endl;
+	cout << "Batch matches sequential = " << (match ? "yes" : "no") << endl;
+}
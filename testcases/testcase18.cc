@@ -0,0 +1,66 @@
+#include "sim_ooo.h"
+#include "sweep.h"
+#include <iostream>
+#include <stdlib.h>
+#include <stdio.h>
+
+using namespace std;
+
+/* Test case for the design-space sweep driver */ 
+/* DO NOT MODIFY */
+
+/* rows of a results file, header first and the rest sorted (points finish in any order) */
+vector<string> rows(const char *filename){
+	ifstream in(filename);
+	vector<string> result;
+	string row;
+	while (getline(in, row)) result.push_back(row);
+	if (result.size() > 1) sort(result.begin() + 1, result.end());
+	return result;
+}
+
+void truncate_last_row(const char *filename, unsigned keep){
+	vector<string> all;
+	ifstream in(filename);
+	string row;
+	while (getline(in, row)) all.push_back(row);
+	in.close();
+	ofstream out(filename, ofstream::trunc);
+	for (unsigned i = 0; i + 1 < all.size(); i++) out << all[i] << endl;
+	out << all.back().substr(0, keep);	// interrupted while writing the last row
+}
+
+int main(int argc, char **argv){
+
+	remove("testcase18.csv");
+	remove("testcase18.json");
+
+	sweep design;
+	design.load_grid("testcases/testcase18.grid");
+
+	unsigned first = design.run("testcase18.csv", 4);
+	unsigned again = design.run("testcase18.csv", 4);
+	vector<string> complete = rows("testcase18.csv");
+
+	truncate_last_row("testcase18.csv", 10);
+	unsigned resumed = design.run("testcase18.csv", 4);
+	bool same = rows("testcase18.csv") == complete;
+
+	unsigned json = design.run("testcase18.json", 2);
+	vector<string> jsonRows = rows("testcase18.json");
+	sort(jsonRows.begin(), jsonRows.end());	// JSON lines have no header
+
+	remove("testcase18.csv");
+	remove("testcase18.json");
+
+	cout << "SWEEP RESULTS" << endl;
+	for (unsigned i = 0; i < complete.size(); i++) cout << complete[i] << endl;
+	cout << endl << jsonRows[0] << endl << endl;
+
+	cout << "Points = " << dec << design.get_points() << endl;
+	cout << "Simulated (first run) = " << first << endl;
+	cout << "Simulated (second run) = " << again << endl;
+	cout << "Simulated (after interruption) = " << resumed << endl;
+	cout << "Resumed results match = " << (same ? "yes" : "no") << endl;
+	cout << "Simulated (JSON) = " << json << ", rows = " << jsonRows.size() << endl;
+}
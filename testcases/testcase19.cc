@@ -0,0 +1,102 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+#include <stdio.h>
+
+using namespace std;
+
+/* Test case for the streaming execution log */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+sim_ooo *build(unsigned base_address = 0x00000000){
+	// instantiates sim_ooo with a 1MB data memory
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   6,           //rob size
+				   3, 2, 2, 2,  //int, add, mult, load reservation stations
+				   2); 		//issue width
+			
+	//initialize execution units
+        ooo->init_exec_unit(INTEGER, 3, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 5, 1);
+
+	//loads program in instruction memory
+	ooo->load_program("asm/sort.asm", base_address);
+
+	//initialize general purpose registers
+	ooo->set_int_register(7, 0x80000000);
+
+        //initialize data memory 
+	unsigned i, j;
+        for (i = 0xA000, j=12; i<0xA030; i+=4, j-=1) ooo->write_memory(i,float2unsigned((float)(j)));
+	return ooo;
+}
+
+/* output of a print function */
+string capture(sim_ooo *ooo, const char *log_file){
+	stringstream out;
+	streambuf *coutbuf = cout.rdbuf(out.rdbuf());
+	if (log_file) print_log_file(log_file);
+	else ooo->print_log();
+	cout.rdbuf(coutbuf);
+	return out.str();
+}
+
+long file_size(const char *filename){
+	ifstream in(filename, ifstream::binary | ifstream::ate);
+	return in.tellg();
+}
+
+int main(int argc, char **argv){
+
+	// in-memory and streamed log side by side
+	sim_ooo *both = build();
+	both->set_log_file("testcase19_both.log");
+	both->run();
+	string memoryLog = capture(both, NULL);
+	string fileLog = capture(both, "testcase19_both.log");
+
+	// streamed only, written in two runs
+	sim_ooo *streamed = build();
+	streamed->set_log_memory(false);
+	streamed->set_log_file("testcase19_streamed.log");
+	streamed->run(1000);
+	streamed->run();
+	streamed->set_log_file(NULL);
+	string emptyLog = capture(streamed, NULL);
+	string streamedLog = capture(streamed, "testcase19_streamed.log");
+
+	// program in the upper half of the address space: PC deltas of -2^31
+	sim_ooo *high = build(0x80000000);
+	high->set_log_file("testcase19_high.log");
+	high->run();
+	high->set_log_file(NULL);
+	string highLog = capture(high, NULL);
+	string highFileLog = capture(high, "testcase19_high.log");
+
+	unsigned records = count(memoryLog.begin(), memoryLog.end(), '\n') - 2;
+	long size = file_size("testcase19_streamed.log");
+
+	remove("testcase19_both.log");
+	remove("testcase19_streamed.log");
+	remove("testcase19_high.log");
+
+	cout << fileLog.substr(0, fileLog.find("0x0000001c")) << endl;
+
+	cout << "File log matches print_log() = " << (fileLog == memoryLog ? "yes" : "no") << endl;
+	cout << "Streamed-only log matches print_log() = " << (streamedLog == memoryLog ? "yes" : "no") << endl;
+	cout << "File log matches print_log() at 0x80000000 = " << (highFileLog == highLog ? "yes" : "no") << endl;
+	cout << "In-memory log when disabled = " << (emptyLog == capture(build(), NULL) ? "empty" : "not empty") << endl;
+	cout << "Records = " << dec << records << endl;
+	cout << "Log file size = " << dec << size << " bytes (" << records * sizeof(instStatT) << " bytes in memory)" << endl;
+}
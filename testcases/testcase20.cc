@@ -0,0 +1,112 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+#include <stdio.h>
+#include <map>
+
+using namespace std;
+
+/* Test case for the Konata pipeline trace */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+sim_ooo *build(){
+	// instantiates sim_ooo with a 1MB data memory
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   6,           //rob size
+				   3, 2, 2, 2,  //int, add, mult, load reservation stations
+				   2); 		//issue width
+			
+	//initialize execution units
+        ooo->init_exec_unit(INTEGER, 3, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 5, 1);
+
+	//loads program in instruction memory at address 0x00000000
+	ooo->load_program("asm/sort.asm", 0x00000000);
+
+	//initialize general purpose registers
+	ooo->set_int_register(7, 0x80000000);
+
+        //initialize data memory 
+	unsigned i, j;
+        for (i = 0xA000, j=12; i<0xA030; i+=4, j-=1) ooo->write_memory(i,float2unsigned((float)(j)));
+	return ooo;
+}
+
+/* rebuilds the execution log from the trace: cycles of the stage starts, in retire order */
+string log_from_trace(const char *filename, unsigned& instructions, unsigned& committed, unsigned& flushed){
+	ifstream in(filename);
+	string line;
+	unsigned cycle = 0;
+	map<unsigned, string> pcs;
+	map<unsigned, map<string, unsigned> > stages;
+	stringstream out;
+	out << "EXECUTION LOG" << endl;
+	out << setw(12) << setfill(' ') << "PC" << setw(7) << "Issue" << setw(7) << "Exe" << setw(7) << "WR" << setw(7) << "Commit" << endl;
+	instructions = committed = flushed = 0;
+	while (getline(in, line)) {
+		stringstream fields(line);
+		string command, a, b, c;
+		getline(fields, command, '\t');
+		getline(fields, a, '\t');
+		getline(fields, b, '\t');
+		getline(fields, c, '\t');
+		unsigned id = strtoul(a.c_str(), NULL, 10);
+		if (command == "C=") cycle = id;
+		else if (command == "C") cycle += id;
+		else if (command == "I") instructions++;
+		else if (command == "L") pcs[id] = c.substr(0, 10);
+		else if (command == "S") stages[id][c] = cycle;
+		else if (command == "R") {
+			if (c == "1") flushed++; else committed++;
+			out << pcs[id];
+			const char *names[4] = {"Is", "Ex", "Wr", "Cm"};
+			for (int s = 0; s < 4; s++) {
+				out << setw(7);
+				if (stages[id].count(names[s])) out << dec << stages[id][names[s]];
+				else out << "-";
+			}
+			out << endl;
+		}
+	}
+	return out.str();
+}
+
+int main(int argc, char **argv){
+
+	sim_ooo *ooo = build();
+	ooo->set_trace_file("testcase20.kanata");
+	ooo->run();
+	ooo->set_trace_file(NULL);
+
+	stringstream log;
+	streambuf *coutbuf = cout.rdbuf(log.rdbuf());
+	ooo->print_log();
+	cout.rdbuf(coutbuf);
+
+	unsigned instructions, committed, flushed;
+	string traced = log_from_trace("testcase20.kanata", instructions, committed, flushed);
+
+	ifstream in("testcase20.kanata");
+	string line;
+	cout << "KONATA TRACE (first lines)" << endl;
+	for (int i = 0; i < 24 && getline(in, line); i++) cout << line << endl;
+	in.close();
+	remove("testcase20.kanata");
+
+	cout << endl;
+	cout << "Traced instructions = " << dec << instructions << endl;
+	cout << "Committed = " << committed << ", squashed = " << flushed << endl;
+	cout << "Instructions executed = " << ooo->get_instructions_executed() << endl;
+	cout << "Trace matches execution log = " << (traced == log.str() ? "yes" : "no") << endl;
+}
@@ -0,0 +1,74 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+using namespace std;
+
+/* Test case for the stall and utilization counters */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+sim_ooo *build(){
+	// instantiates sim_ooo with a 1MB data memory
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   6,           //rob size
+				   3, 2, 2, 2,  //int, add, mult, load reservation stations
+				   2); 		//issue width
+			
+	//initialize execution units
+        ooo->init_exec_unit(INTEGER, 3, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 5, 1);
+
+	//loads program in instruction memory at address 0x00000000
+	ooo->load_program("asm/sort.asm", 0x00000000);
+
+	//initialize general purpose registers
+	ooo->set_int_register(7, 0x80000000);
+
+        //initialize data memory 
+	unsigned i, j;
+        for (i = 0xA000, j=12; i<0xA030; i+=4, j-=1) ooo->write_memory(i,float2unsigned((float)(j)));
+	return ooo;
+}
+
+/* every counter, as text */
+string counters(sim_ooo *ooo){
+	stringstream out;
+	streambuf *coutbuf = cout.rdbuf(out.rdbuf());
+	ooo->print_counters();
+	cout.rdbuf(coutbuf);
+	for (int i = 0; i < EX_TOTAL; i++) out << ooo->get_busy_lane_cycles((exe_unit_t)i) << " ";
+	for (int i = 0; i < RS_TOTAL; i++) out << ooo->get_res_station_occupancy((res_station_t)i) << " ";
+	out << ooo->get_rob_occupancy() << endl;
+	return out.str();
+}
+
+int main(int argc, char **argv){
+
+	sim_ooo *skipping = build();
+	skipping->run();
+
+	// cycle by cycle: the counters must not depend on skipping idle cycles
+	sim_ooo *stepping = build();
+	stepping->set_cycle_skipping(false);
+	stepping->run();
+
+	unsigned commitStalls = 0;
+	for (int i = 0; i < COMMIT_STALL_TOTAL; i++) commitStalls += skipping->get_commit_stall_cycles((commit_stall_t)i);
+
+	cout << counters(skipping) << endl;
+
+	cout << "Counters match without cycle skipping = " << (counters(skipping) == counters(stepping) ? "yes" : "no") << endl;
+	cout << "Skipped cycles = " << dec << skipping->get_skipped_cycles() << endl;
+	cout << "Commit stall cycles + instructions = " << commitStalls + skipping->get_instructions_executed() << endl;
+}
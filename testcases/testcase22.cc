@@ -0,0 +1,79 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+using namespace std;
+
+/* Test case for the buffered status printer */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+sim_ooo *build(){
+	// instantiates sim_ooo with a 1MB data memory
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   6,           //rob size
+				   3, 2, 2, 2,  //int, add, mult, load reservation stations
+				   2); 		//issue width
+			
+	//initialize execution units
+        ooo->init_exec_unit(INTEGER, 3, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 5, 1);
+
+	//loads program in instruction memory at address 0x00000000
+	ooo->load_program("asm/sort.asm", 0x00000000);
+
+	//initialize general purpose registers
+	ooo->set_int_register(7, 0x80000000);
+
+        //initialize data memory 
+	unsigned i, j;
+        for (i = 0xA000, j=12; i<0xA030; i+=4, j-=1) ooo->write_memory(i,float2unsigned((float)(j)));
+	return ooo;
+}
+
+/* prints the status every cycle until the end, plus stream state left behind */
+string traced(bool fast, bool hexFirst){
+	sim_ooo *ooo = build();
+	ooo->set_fast_print(fast);
+	stringstream out;
+	streambuf *coutbuf = cout.rdbuf(out.rdbuf());
+	if (hexFirst) cout << hex << setfill('*');
+	for (unsigned c = 0; c < 400; c++) {
+		ooo->run(1);
+		ooo->print_status();
+		ooo->print_rob();
+		ooo->print_reservation_stations();
+		ooo->print_registers();
+		ooo->print_pending_instructions();
+		// output that depends on what the printers left in the stream
+		cout << setw(4) << 255 << setw(3) << 7 << endl;
+	}
+	cout.rdbuf(coutbuf);
+	cout << dec << setfill(' ');
+	delete ooo;
+	return out.str();
+}
+
+int main(int argc, char **argv){
+
+	string stream = traced(false, false);
+	string fast = traced(true, false);
+	string streamHex = traced(false, true);
+	string fastHex = traced(true, true);
+
+	cout << fast.substr(0, fast.find("GENERAL PURPOSE REGISTERS")) << endl;
+
+	cout << "Output size = " << dec << fast.size() << " bytes" << endl;
+	cout << "Buffered output matches stream output = " << (fast == stream ? "yes" : "no") << endl;
+	cout << "Buffered output matches stream output (hex, fill '*') = " << (fastHex == streamHex ? "yes" : "no") << endl;
+}
@@ -0,0 +1,90 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+using namespace std;
+
+/* Test case for the sparse data memory: multi-GB memories and reset */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+sim_ooo *build(unsigned memory_size){
+	// instantiates sim_ooo with the given data memory
+	sim_ooo *ooo = new sim_ooo(memory_size,	//memory size 
+				   6,           //rob size
+				   3, 2, 2, 2,  //int, add, mult, load reservation stations
+				   2); 		//issue width
+			
+	//initialize execution units
+        ooo->init_exec_unit(INTEGER, 3, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 5, 1);
+
+	//loads program in instruction memory at address 0x00000000
+	ooo->load_program("asm/sort.asm", 0x00000000);
+
+	//initialize general purpose registers
+	ooo->set_int_register(7, 0x80000000);
+
+        //initialize data memory 
+	unsigned i, j;
+        for (i = 0xA000, j=12; i<0xA030; i+=4, j-=1) ooo->write_memory(i,float2unsigned((float)(j)));
+	return ooo;
+}
+
+/* architectural state: registers and the sorted array */
+string state(sim_ooo *ooo){
+	stringstream out;
+	streambuf *coutbuf = cout.rdbuf(out.rdbuf());
+	ooo->print_registers();
+	ooo->print_memory(0xB000, 0xB030);
+	cout.rdbuf(coutbuf);
+	return out.str();
+}
+
+int main(int argc, char **argv){
+
+	// reference: 1MB data memory
+	sim_ooo *small = build(1024*1024);
+	small->run();
+
+	// 3GB data memory: only the pages the program writes are allocated
+	sim_ooo *large = build(0xC0000000);
+	large->run();
+
+	cout << "PROGRAM TERMINATED\n";
+	cout << "===================" << endl << endl;
+
+	cout << state(large) << endl;
+
+	cout << "3GB memory matches 1MB memory = " << (state(large) == state(small) ? "yes" : "no") << endl;
+	cout << "Dirty pages after run = " << dec << large->get_dirty_memory_pages() << endl;
+
+	// words at both ends of the address space
+	large->write_memory(0x00000000, 0x01234567);
+	large->write_memory(0xBFFFFFFC, 0x89ABCDEF);
+	cout << "Dirty pages after writes = " << dec << large->get_dirty_memory_pages() << endl;
+	cout << "Last word = " << hex << large->read_memory(0xBFFFFFFC) << endl;
+	cout << "Untouched word = " << hex << large->read_memory(0x40000000) << endl;
+	large->print_memory(0xBFFFFFF0, 0xC0000000);
+	cout << endl;
+
+	// reset only visits the pages written
+	large->reset();
+	cout << "Dirty pages after reset = " << dec << large->get_dirty_memory_pages() << endl;
+	cout << "Last word after reset = " << hex << large->read_memory(0xBFFFFFFC) << endl;
+	large->print_memory(0xB000, 0xB010);
+	cout << endl;
+
+	cout << "Clock cycles = " << dec << large->get_clock_cycles() << endl;
+	cout << "IPC = " << dec << large->get_IPC() << endl;
+}
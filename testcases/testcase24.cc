@@ -0,0 +1,104 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+using namespace std;
+
+/* Test case for data memory images: mapped loading and dumping */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+sim_ooo *build(){
+	// instantiates sim_ooo with a 1MB data memory
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   16,          //rob size
+				   4, 4, 4, 4,  //int, add, mult, load reservation stations
+				   2); 		//issue width
+			
+	//initialize execution units
+        ooo->init_exec_unit(INTEGER, 2, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 5, 1);
+
+	//loads program in instruction memory at address 0x00000000
+	ooo->load_program("asm/stream.asm", 0x00000000);
+	return ooo;
+}
+
+/* architectural state: registers and the start of the output stream */
+string state(sim_ooo *ooo){
+	stringstream out;
+	streambuf *coutbuf = cout.rdbuf(out.rdbuf());
+	ooo->print_registers();
+	ooo->print_memory(0xC000, 0xC020);
+	cout.rdbuf(coutbuf);
+	return out.str();
+}
+
+string file(const char *filename){
+	ifstream in(filename, ifstream::in | ifstream::binary);
+	stringstream content;
+	content << in.rdbuf();
+	return content.str();
+}
+
+int main(int argc, char **argv){
+	unsigned i;
+
+	// reference: input stream written word by word, then saved as an image
+	sim_ooo *words = build();
+	for (i = 0; i < 2001; i++) words->write_memory(0xA000 + 4*i, float2unsigned((float)i));
+	words->dump_memory_image("testcase24_input.img", 0xA000, 0xA000 + 4*2001);
+	words->run();
+	words->dump_memory_image("testcase24_words.img", 0xC000, 0xC000 + 4*2001);
+
+	// input stream mapped from the image
+	sim_ooo *mapped = build();
+	mapped->load_data_image("testcase24_input.img", 0xA000);
+	cout << "Dirty pages after load = " << dec << mapped->get_dirty_memory_pages() << endl;
+	mapped->run();
+	mapped->dump_memory_image("testcase24_mapped.img", 0xC000, 0xC000 + 4*2001);
+
+	cout << "PROGRAM TERMINATED\n";
+	cout << "===================" << endl << endl;
+
+	cout << state(mapped) << endl;
+
+	cout << "Image size = " << dec << file("testcase24_input.img").size() << endl;
+	cout << "Mapped input matches written input = " << (state(mapped) == state(words) ? "yes" : "no") << endl;
+	cout << "Mapped output image matches = " << (file("testcase24_mapped.img") == file("testcase24_words.img") ? "yes" : "no") << endl;
+
+	// writes to mapped pages stay private to the simulator
+	mapped->write_memory(0xA000, 0x12345678);
+	sim_ooo *other = build();
+	other->load_data_image("testcase24_input.img", 0xA000);
+	cout << "Written word = " << hex << mapped->read_memory(0xA000) << endl;
+	cout << "Word in other simulator = " << hex << other->read_memory(0xA000) << endl;
+	cout << "Word at the end of the image = " << hex << other->read_memory(0xA000 + 4*2000) << endl;
+	cout << "Word past the image = " << hex << other->read_memory(0xA000 + 4*2001) << endl;
+
+	// unaligned base addresses are copied
+	other->load_data_image("testcase24_input.img", 0x20004);
+	cout << "Words at unaligned base = " << hex << other->read_memory(0x20004) << " " << other->read_memory(0x20004 + 4*2000) << endl;
+
+	// reset drops the mapping
+	mapped->reset();
+	cout << "Dirty pages after reset = " << dec << mapped->get_dirty_memory_pages() << endl;
+	cout << "Word after reset = " << hex << mapped->read_memory(0xA000) << endl;
+
+	remove("testcase24_input.img");
+	remove("testcase24_words.img");
+	remove("testcase24_mapped.img");
+
+	cout << "Clock cycles = " << dec << mapped->get_clock_cycles() << endl;
+	cout << "IPC = " << dec << mapped->get_IPC() << endl;
+}
@@ -0,0 +1,123 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+using namespace std;
+
+/* Test case for the assembler and the cache of decoded programs */ 
+/* DO NOT MODIFY */
+
+/* writes a generated program: a loop over a long body with forward branches */
+void generate(const char *filename, unsigned iterations){
+	ofstream out(filename);
+	out << "\tXOR R0 R0 R0\n";
+	out << "\tADDI R1 R0 " << iterations << "\n";
+	out << "\tADDI R3 R0 0xA000\n";
+	out << "LOOP:\tLWS F1 0(R3)\n";
+	for (unsigned i = 0; i < 1000; i++) {
+		if (i % 100 == 50) out << "\tBEQZ R0 SKIP" << i << "\n\tADDI R2 R2 -1000\n";
+		if (i % 100 == 51) out << "SKIP" << (i - 1) << ":\tSUBI R2 R2 -2\n";
+		else if (i % 3 == 0) out << "\tADDI R2 R2 " << i << "\t\n";
+		else if (i % 3 == 1) out << "\tADDS F2 F2 F1\n";
+		else out << "\tSUB R4 R2 R4\n";
+	}
+	out << "\tSWS F2 0x10(R3)\n";
+	out << "\tSUBI R1 R1 1\n";
+	out << "\tBNEZ R1 LOOP\n";
+	out << "\tSW R2 4(R3)\n";
+	out << "EOP\n";
+}
+
+/* overwrites one byte of a file */
+void corrupt(const char *filename, unsigned offset, unsigned char value){
+	fstream file(filename, fstream::in | fstream::out | fstream::binary);
+	file.seekp(offset);
+	file.put(value);
+}
+
+sim_ooo *build(bool cache){
+	// instantiates sim_ooo with a 1MB data memory
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   16,          //rob size
+				   4, 4, 4, 4,  //int, add, mult, load reservation stations
+				   2); 		//issue width
+			
+	//initialize execution units
+        ooo->init_exec_unit(INTEGER, 1, 2);
+        ooo->init_exec_unit(ADDER, 2, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 2, 1);
+
+	ooo->set_program_cache(cache);
+	//loads program in instruction memory at address 0x00000000
+	ooo->load_program("testcase25.asm", 0x00000000);
+
+        //initialize data memory 
+	ooo->write_memory(0xA000, 0x3F800000);
+	return ooo;
+}
+
+/* architectural state: registers and results */
+string state(sim_ooo *ooo){
+	stringstream out;
+	streambuf *coutbuf = cout.rdbuf(out.rdbuf());
+	ooo->print_registers();
+	ooo->print_memory(0xA000, 0xA014);
+	cout.rdbuf(coutbuf);
+	return out.str();
+}
+
+int main(int argc, char **argv){
+
+	generate("testcase25.asm", 20);
+	remove("testcase25.asm.cache");
+
+	// reference: parsed, no cache
+	sim_ooo *parsed = build(false);
+	parsed->run();
+
+	// first load parses and writes the cache, the second one reads it
+	sim_ooo *writer = build(true);
+	sim_ooo *cached = build(true);
+	cached->run();
+
+	cout << "PROGRAM TERMINATED\n";
+	cout << "===================" << endl << endl;
+
+	cout << state(cached) << endl;
+
+	cout << "Parsed program cached = " << (parsed->get_program_cached() ? "yes" : "no") << endl;
+	cout << "First cached load from cache = " << (writer->get_program_cached() ? "yes" : "no") << endl;
+	cout << "Second cached load from cache = " << (cached->get_program_cached() ? "yes" : "no") << endl;
+	cout << "Cached program matches parsed program = " << (state(cached) == state(parsed) ? "yes" : "no") << endl;
+
+	// a changed source does not match the cache
+	generate("testcase25.asm", 5);
+	sim_ooo *changed = build(true);
+	sim_ooo *reparsed = build(false);
+	changed->run();
+	reparsed->run();
+	cout << "Changed program from cache = " << (changed->get_program_cached() ? "yes" : "no") << endl;
+	cout << "Changed program matches parsed program = " << (state(changed) == state(reparsed) ? "yes" : "no") << endl;
+	cout << "Instructions executed (20 iterations) = " << dec << cached->get_instructions_executed() << endl;
+	cout << "Instructions executed (5 iterations) = " << dec << changed->get_instructions_executed() << endl;
+
+	// a corrupt cache is parsed again (records start after a 24-byte header, 10 bytes each)
+	corrupt("testcase25.asm.cache", 24 + 3, 40);
+	sim_ooo *badRegister = build(true);
+	badRegister->run();
+	corrupt("testcase25.asm.cache", 24 + 10, 0xEE);
+	sim_ooo *badOpcode = build(true);
+	badOpcode->run();
+	cout << "Cache with a bad register from cache = " << (badRegister->get_program_cached() ? "yes" : "no") << endl;
+	cout << "Cache with a bad opcode from cache = " << (badOpcode->get_program_cached() ? "yes" : "no") << endl;
+	cout << "Corrupt caches match parsed program = " << (state(badRegister) == state(reparsed) && state(badOpcode) == state(reparsed) ? "yes" : "no") << endl;
+
+	remove("testcase25.asm");
+	remove("testcase25.asm.cache");
+
+	cout << "Clock cycles = " << dec << cached->get_clock_cycles() << endl;
+	cout << "IPC = " << dec << cached->get_IPC() << endl;
+}
@@ -0,0 +1,107 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+using namespace std;
+
+/* Test case for the commit width */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+/* loop over an array (configuration of testcase6) */
+sim_ooo *build_loop(unsigned commit_width){
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   6,           //rob size
+				   2, 2, 2, 2,  //int, add, mult, load reservation stations
+				   2,		//issue width
+				   0,		//load/store queue (same as ROB)
+				   commit_width);	//commit width
+			
+        ooo->init_exec_unit(INTEGER, 2, 1);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 5, 1);
+
+	ooo->load_program("asm/code_ooo3.asm", 0x00000000);
+
+	ooo->set_int_register(0, 0);
+	ooo->set_int_register(2, 6);
+	ooo->set_int_register(3, 0xA000);
+	ooo->set_fp_register(1, 0.0);
+	ooo->set_fp_register(2, 0.0);
+	ooo->set_fp_register(3, 0.0);
+	ooo->set_fp_register(4, 0.0);
+	unsigned i, j;
+        for (i = 0xA000, j=0; i<0xA020; i+=4, j+=1) ooo->write_memory(i,float2unsigned((float)(j)));
+	return ooo;
+}
+
+/* sort: mispredicted branches and stores */
+sim_ooo *build_sort(unsigned commit_width){
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   16,          //rob size
+				   4, 4, 4, 4,  //int, add, mult, load reservation stations
+				   4,		//issue width
+				   0,		//load/store queue (same as ROB)
+				   commit_width);	//commit width
+			
+        ooo->init_exec_unit(INTEGER, 1, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 2, 1);
+
+	ooo->load_program("asm/sort.asm", 0x00000000);
+	ooo->set_int_register(7, 0x80000000);
+	unsigned i, j;
+        for (i = 0xA000, j=12; i<0xA030; i+=4, j-=1) ooo->write_memory(i,float2unsigned((float)(j)));
+	return ooo;
+}
+
+/* architectural state: registers and memory */
+string state(sim_ooo *ooo){
+	stringstream out;
+	streambuf *coutbuf = cout.rdbuf(out.rdbuf());
+	ooo->print_registers();
+	ooo->print_memory(0xA000, 0xA030);
+	ooo->print_memory(0xB000, 0xB030);
+	cout.rdbuf(coutbuf);
+	return out.str();
+}
+
+int main(int argc, char **argv){
+	unsigned widths[3] = {1, 2, 4};
+	sim_ooo *loop[3], *sort[3];
+
+	for (int w = 0; w < 3; w++) {
+		loop[w] = build_loop(widths[w]);
+		loop[w]->run();
+		sort[w] = build_sort(widths[w]);
+		sort[w]->run();
+	}
+
+	cout << "PROGRAM TERMINATED\n";
+	cout << "===================" << endl << endl;
+
+	// execution log of the loop retiring two instructions per cycle
+	loop[1]->print_log();
+	cout << endl;
+
+	for (int w = 0; w < 3; w++) {
+		cout << "Commit width " << dec << widths[w] << endl;
+		cout << "  loop: instructions = " << dec << loop[w]->get_instructions_executed() << ", cycles = " << dec << loop[w]->get_clock_cycles()
+		     << ", IPC = " << loop[w]->get_IPC() << ", ROB stalls = " << dec << loop[w]->get_issue_stall_cycles(STALL_ROB)
+		     << ", state matches width 1 = " << (state(loop[w]) == state(loop[0]) ? "yes" : "no") << endl;
+		cout << "  sort: instructions = " << dec << sort[w]->get_instructions_executed() << ", cycles = " << dec << sort[w]->get_clock_cycles()
+		     << ", IPC = " << sort[w]->get_IPC() << ", ROB stalls = " << dec << sort[w]->get_issue_stall_cycles(STALL_ROB)
+		     << ", state matches width 1 = " << (state(sort[w]) == state(sort[0]) ? "yes" : "no") << endl;
+	}
+}
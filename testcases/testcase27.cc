@@ -0,0 +1,137 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+#include <stdio.h>
+
+using namespace std;
+
+/* Test case for the branch predictors */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+/* loop over an array (code_ooo2.asm) */
+sim_ooo *build_loop(predictor_t predictor){
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   8,           //rob size
+				   2, 3, 2, 2,  //int, add, mult, load reservation stations
+				   2);		//issue width
+			
+        ooo->init_exec_unit(INTEGER, 1, 1);
+        ooo->init_exec_unit(ADDER, 3, 1);
+        ooo->init_exec_unit(MULTIPLIER, 5, 1);
+        ooo->init_exec_unit(DIVIDER, 10, 1);
+        ooo->init_exec_unit(MEMORY, 2, 1);
+	ooo->set_branch_predictor(predictor, 10, 64);
+
+	ooo->load_program("asm/code_ooo2.asm", 0x00000000);
+
+	unsigned i, j;
+	for (i=0; i<5; i++) ooo->set_fp_register(i, (float)i);
+        for (i = 0xA000, j=0; i<0xA020; i+=4, j+=1) ooo->write_memory(i,float2unsigned((float)(j+1)));
+	return ooo;
+}
+
+/* sort: loop back-edges and a data-dependent branch */
+sim_ooo *build_sort(predictor_t predictor){
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   16,          //rob size
+				   4, 4, 4, 4,  //int, add, mult, load reservation stations
+				   4);		//issue width
+			
+        ooo->init_exec_unit(INTEGER, 1, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 2, 1);
+	ooo->set_branch_predictor(predictor, 10, 64);
+
+	ooo->load_program("asm/sort.asm", 0x00000000);
+	ooo->set_int_register(7, 0x80000000);
+	unsigned i, j;
+        for (i = 0xA000, j=12; i<0xA030; i+=4, j-=1) ooo->write_memory(i,float2unsigned((float)(j)));
+	return ooo;
+}
+
+/* architectural state: registers and memory */
+string state(sim_ooo *ooo){
+	stringstream out;
+	streambuf *coutbuf = cout.rdbuf(out.rdbuf());
+	ooo->print_registers();
+	ooo->print_memory(0xA000, 0xA030);
+	ooo->print_memory(0xB000, 0xB030);
+	cout.rdbuf(coutbuf);
+	return out.str();
+}
+
+int main(int argc, char **argv){
+	const char *names[PREDICTOR_TOTAL] = {"not-taken", "bimodal", "gshare", "TAGE"};
+	sim_ooo *loop[PREDICTOR_TOTAL], *sort[PREDICTOR_TOTAL];
+
+	for (int p = 0; p < PREDICTOR_TOTAL; p++) {
+		loop[p] = build_loop((predictor_t)p);
+		loop[p]->run();
+		sort[p] = build_sort((predictor_t)p);
+		sort[p]->run();
+	}
+
+	cout << "PROGRAM TERMINATED\n";
+	cout << "===================" << endl << endl;
+
+	// execution log of the loop with a bimodal predictor
+	loop[PREDICT_BIMODAL]->print_log();
+	cout << endl;
+
+	for (int p = 0; p < PREDICTOR_TOTAL; p++) {
+		cout << "Predictor " << names[p] << endl;
+		cout << "  loop: instructions = " << dec << loop[p]->get_instructions_executed() << ", cycles = " << dec << loop[p]->get_clock_cycles()
+		     << ", IPC = " << loop[p]->get_IPC() << ", branches = " << dec << loop[p]->get_branches()
+		     << ", mispredicted = " << dec << loop[p]->get_branch_mispredictions()
+		     << ", state matches not-taken = " << (state(loop[p]) == state(loop[0]) ? "yes" : "no") << endl;
+		cout << "  sort: instructions = " << dec << sort[p]->get_instructions_executed() << ", cycles = " << dec << sort[p]->get_clock_cycles()
+		     << ", IPC = " << sort[p]->get_IPC() << ", branches = " << dec << sort[p]->get_branches()
+		     << ", mispredicted = " << dec << sort[p]->get_branch_mispredictions()
+		     << ", state matches not-taken = " << (state(sort[p]) == state(sort[0]) ? "yes" : "no") << endl;
+	}
+	cout << endl;
+
+	for (int p = 0; p < PREDICTOR_TOTAL; p++) {
+		sort[p]->print_branch_stats();
+		cout << endl;
+	}
+
+	// a warm predictor mispredicts the inner loop back-edge less
+	cout << "Inner loop back-edge accuracy: not-taken = " << sort[PREDICT_NOT_TAKEN]->get_branch_accuracy(0x70)
+	     << ", gshare = " << sort[PREDICT_GSHARE]->get_branch_accuracy(0x70) << endl;
+
+	// fast-forward warms the predictor up
+	sim_ooo *warm = build_sort(PREDICT_GSHARE);
+	warm->fast_forward(200);
+	warm->run();
+	cout << "Fast-forwarded sort: branches = " << dec << warm->get_branches() << ", mispredicted = " << dec << warm->get_branch_mispredictions()
+	     << ", state matches = " << (state(warm) == state(sort[0]) ? "yes" : "no") << endl;
+
+	// a checkpoint taken mid-run carries the predictor and its statistics
+	for (int p = 0; p < PREDICTOR_TOTAL; p++) {
+		sim_ooo *saver = build_sort((predictor_t)p);
+		saver->run(150);
+		saver->save_checkpoint("testcase27.ckpt", true);
+		sim_ooo *restored = build_sort((predictor_t)p);
+		restored->restore_checkpoint("testcase27.ckpt");
+		restored->run();
+		cout << "Restored sort (" << names[p] << "): cycles = " << dec << restored->get_clock_cycles()
+		     << ", mispredicted = " << dec << restored->get_branch_mispredictions()
+		     << ", matches uninterrupted run = " << (restored->get_clock_cycles() == sort[p]->get_clock_cycles() &&
+		                                             restored->get_branch_mispredictions() == sort[p]->get_branch_mispredictions() &&
+		                                             state(restored) == state(sort[p]) ? "yes" : "no") << endl;
+		delete saver;
+		delete restored;
+	}
+	remove("testcase27.ckpt");
+}
@@ -0,0 +1,136 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+#include <stdio.h>
+
+using namespace std;
+
+/* Test case for early branch misprediction recovery */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+/* loop over an array with a nested loop (code_ooo3.asm) */
+sim_ooo *build_loop(bool early_recovery){
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   8,           //rob size
+				   2, 2, 2, 2,  //int, add, mult, load reservation stations
+				   2);		//issue width
+			
+        ooo->init_exec_unit(INTEGER, 1, 1);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 5, 1);
+	ooo->set_early_recovery(early_recovery);
+
+	ooo->load_program("asm/code_ooo3.asm", 0x00000000);
+
+	ooo->set_int_register(0, 0);
+	ooo->set_int_register(2, 2);
+	ooo->set_int_register(3, 0xA000);
+	for (int i = 1; i < 5; i++) ooo->set_fp_register(i, 0.0);
+	unsigned i, j;
+        for (i = 0xA000, j=0; i<0xA020; i+=4, j+=1) ooo->write_memory(i,float2unsigned((float)(j)));
+	return ooo;
+}
+
+/* sort: loop back-edges and a data-dependent branch */
+sim_ooo *build_sort(predictor_t predictor, bool early_recovery){
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   16,          //rob size
+				   4, 4, 4, 4,  //int, add, mult, load reservation stations
+				   4,		//issue width
+				   0,		//load/store queue (same as ROB)
+				   2);		//commit width
+			
+        ooo->init_exec_unit(INTEGER, 1, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 2, 1);
+	ooo->set_branch_predictor(predictor, 10, 64);
+	ooo->set_early_recovery(early_recovery);
+
+	ooo->load_program("asm/sort.asm", 0x00000000);
+	ooo->set_int_register(7, 0x80000000);
+	unsigned i, j;
+        for (i = 0xA000, j=5; i<0xA030; i+=4, j+=7) ooo->write_memory(i,float2unsigned((float)(j % 11)));
+	return ooo;
+}
+
+/* architectural state: registers and memory */
+string state(sim_ooo *ooo){
+	stringstream out;
+	streambuf *coutbuf = cout.rdbuf(out.rdbuf());
+	ooo->print_registers();
+	ooo->print_memory(0xA000, 0xA030);
+	ooo->print_memory(0xB000, 0xB030);
+	cout.rdbuf(coutbuf);
+	return out.str();
+}
+
+int main(int argc, char **argv){
+	const char *names[PREDICTOR_TOTAL] = {"not-taken", "bimodal", "gshare", "TAGE"};
+
+	sim_ooo *loop[2];
+	for (int e = 0; e < 2; e++) {
+		loop[e] = build_loop(e == 1);
+		loop[e]->run();
+	}
+
+	cout << "PROGRAM TERMINATED\n";
+	cout << "===================" << endl << endl;
+
+	// execution log of the nested loop, recovering at write result
+	loop[1]->print_log();
+	cout << endl;
+
+	cout << "Nested loop: cycles at commit = " << dec << loop[0]->get_clock_cycles() << ", cycles at write result = " << dec << loop[1]->get_clock_cycles()
+	     << ", recoveries = " << dec << loop[1]->get_early_recoveries() << ", state matches = " << (state(loop[1]) == state(loop[0]) ? "yes" : "no") << endl;
+
+	// sorting with each predictor, recovering at commit and at write result
+	string reference;
+	for (int p = 0; p < PREDICTOR_TOTAL; p++) {
+		sim_ooo *sort[2];
+		for (int e = 0; e < 2; e++) {
+			sort[e] = build_sort((predictor_t)p, e == 1);
+			sort[e]->run();
+		}
+		if (p == 0) reference = state(sort[0]);
+		cout << "Predictor " << names[p] << ": mispredicted = " << dec << sort[0]->get_branch_mispredictions()
+		     << ", cycles at commit = " << dec << sort[0]->get_clock_cycles() << ", cycles at write result = " << dec << sort[1]->get_clock_cycles()
+		     << ", recoveries = " << dec << sort[1]->get_early_recoveries()
+		     << ", state matches = " << (state(sort[0]) == reference && state(sort[1]) == reference ? "yes" : "no") << endl;
+		delete sort[0];
+		delete sort[1];
+	}
+
+	// a checkpoint taken mid-run carries the recovery count
+	sim_ooo *uninterrupted = build_sort(PREDICT_BIMODAL, true);
+	uninterrupted->run();
+	unsigned points[3] = {100, 400, 700};
+	for (int c = 0; c < 3; c++) {
+		sim_ooo *saver = build_sort(PREDICT_BIMODAL, true);
+		saver->run(points[c]);
+		saver->save_checkpoint("testcase28.ckpt", true);
+		sim_ooo *restored = build_sort(PREDICT_BIMODAL, true);
+		restored->restore_checkpoint("testcase28.ckpt");
+		restored->run();
+		cout << "Sort restored at cycle " << dec << points[c] << ": cycles = " << dec << restored->get_clock_cycles()
+		     << ", recoveries = " << dec << restored->get_early_recoveries()
+		     << ", matches uninterrupted run = " << (restored->get_clock_cycles() == uninterrupted->get_clock_cycles() &&
+		                                             restored->get_early_recoveries() == uninterrupted->get_early_recoveries() &&
+		                                             state(restored) == state(uninterrupted) ? "yes" : "no") << endl;
+		delete saver;
+		delete restored;
+	}
+	remove("testcase28.ckpt");
+	delete uninterrupted;
+}
@@ -0,0 +1,155 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+#include <stdio.h>
+
+using namespace std;
+
+/* Test case for store-set memory dependence prediction */ 
+/* DO NOT MODIFY */
+
+/* convert a float into an unsigned */
+inline unsigned float2unsigned(float value){
+        unsigned result;
+        memcpy(&result, &value, sizeof value);
+        return result;
+}
+
+/* scatter through an index array, then read the destination array in order (scatter.asm) */
+/* every "alias"-th index points at the element read in the same iteration */
+sim_ooo *build_scatter(bool store_sets, unsigned alias){
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   32,          //rob size
+				   4, 4, 4, 8,  //int, add, mult, load reservation stations
+				   4,		//issue width
+				   0,		//load/store queue (same as ROB)
+				   4);		//commit width
+			
+        ooo->init_exec_unit(INTEGER, 1, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 2, 2);
+	ooo->set_branch_predictor(PREDICT_BIMODAL, 10, 64);
+	ooo->set_store_sets(store_sets);
+
+	ooo->load_program("asm/scatter.asm", 0x00000000);
+
+	ooo->set_int_register(2, 40);
+	unsigned i;
+        for (i = 0; i < 40; i++) ooo->write_memory(0xA000 + 4*i, (i % alias == alias - 1) ? i : (i*7+3) % 500 + 1000);
+	return ooo;
+}
+
+/* sort: stores whose addresses are known early */
+sim_ooo *build_sort(bool store_sets){
+	sim_ooo *ooo = new sim_ooo(1024*1024,	//memory size 
+				   16,          //rob size
+				   4, 4, 4, 4,  //int, add, mult, load reservation stations
+				   4,		//issue width
+				   0,		//load/store queue (same as ROB)
+				   2);		//commit width
+			
+        ooo->init_exec_unit(INTEGER, 1, 2);
+        ooo->init_exec_unit(ADDER, 3, 2);
+        ooo->init_exec_unit(MULTIPLIER, 10, 1);
+        ooo->init_exec_unit(DIVIDER, 40, 1);
+        ooo->init_exec_unit(MEMORY, 2, 1);
+	ooo->set_branch_predictor(PREDICT_GSHARE, 10, 64);
+	ooo->set_early_recovery(true);
+	ooo->set_store_sets(store_sets);
+
+	ooo->load_program("asm/sort.asm", 0x00000000);
+	ooo->set_int_register(7, 0x80000000);
+	unsigned i, j;
+        for (i = 0xA000, j=5; i<0xA030; i+=4, j+=7) ooo->write_memory(i,float2unsigned((float)(j % 11)));
+	return ooo;
+}
+
+/* architectural state: registers and memory */
+string state(sim_ooo *ooo){
+	stringstream out;
+	streambuf *coutbuf = cout.rdbuf(out.rdbuf());
+	ooo->print_registers();
+	ooo->print_memory(0xA000, 0xA030);
+	ooo->print_memory(0xB000, 0xB030);
+	ooo->print_memory(0xC000, 0xC0A0);
+	cout.rdbuf(coutbuf);
+	return out.str();
+}
+
+int main(int argc, char **argv){
+	unsigned aliases[3] = {1000, 8, 1};
+
+	sim_ooo *scatter[2];
+	for (int s = 0; s < 2; s++) {
+		scatter[s] = build_scatter(s == 1, 8);
+		scatter[s]->run();
+	}
+
+	cout << "PROGRAM TERMINATED\n";
+	cout << "===================" << endl << endl;
+
+	// execution log of the scatter loop, with store sets
+	scatter[1]->print_log();
+	cout << endl;
+	delete scatter[0];
+	delete scatter[1];
+
+	// scatter loop with more or fewer aliasing iterations, without and with store sets
+	for (int a = 0; a < 3; a++) {
+		for (int s = 0; s < 2; s++) {
+			scatter[s] = build_scatter(s == 1, aliases[a]);
+			scatter[s]->run();
+		}
+		cout << "Scatter (alias every " << dec << aliases[a] << "): cycles without store sets = " << dec << scatter[0]->get_clock_cycles()
+		     << ", cycles with store sets = " << dec << scatter[1]->get_clock_cycles()
+		     << ", speculative loads = " << dec << scatter[1]->get_speculative_loads()
+		     << ", violations = " << dec << scatter[1]->get_memory_violations()
+		     << ", replays = " << dec << scatter[1]->get_load_replays()
+		     << ", state matches = " << (state(scatter[0]) == state(scatter[1]) ? "yes" : "no") << endl;
+		delete scatter[0];
+		delete scatter[1];
+	}
+
+	sim_ooo *sort[2];
+	for (int s = 0; s < 2; s++) {
+		sort[s] = build_sort(s == 1);
+		sort[s]->run();
+	}
+	cout << "Sort: cycles without store sets = " << dec << sort[0]->get_clock_cycles()
+	     << ", cycles with store sets = " << dec << sort[1]->get_clock_cycles()
+	     << ", speculative loads = " << dec << sort[1]->get_speculative_loads()
+	     << ", violations = " << dec << sort[1]->get_memory_violations()
+	     << ", replays = " << dec << sort[1]->get_load_replays()
+	     << ", state matches = " << (state(sort[0]) == state(sort[1]) ? "yes" : "no") << endl;
+	delete sort[0];
+	delete sort[1];
+
+	// a checkpoint taken mid-run carries the store sets and their counts
+	sim_ooo *reference = build_scatter(true, 8);
+	reference->run();
+	unsigned points[3] = {60, 150, 300};
+	for (int c = 0; c < 3; c++) {
+		sim_ooo *saver = build_scatter(true, 8);
+		saver->run(points[c]);
+		saver->save_checkpoint("testcase29.ckpt", true);
+		sim_ooo *restored = build_scatter(true, 8);
+		restored->restore_checkpoint("testcase29.ckpt");
+		restored->run();
+		cout << "Scatter restored at cycle " << dec << points[c] << ": cycles = " << dec << restored->get_clock_cycles()
+		     << ", speculative loads = " << dec << restored->get_speculative_loads()
+		     << ", violations = " << dec << restored->get_memory_violations()
+		     << ", replays = " << dec << restored->get_load_replays()
+		     << ", matches uninterrupted run = " << (restored->get_clock_cycles() == reference->get_clock_cycles() &&
+		                                             restored->get_speculative_loads() == reference->get_speculative_loads() &&
+		                                             restored->get_memory_violations() == reference->get_memory_violations() &&
+		                                             restored->get_load_replays() == reference->get_load_replays() &&
+		                                             state(restored) == state(reference) ? "yes" : "no") << endl;
+		delete saver;
+		delete restored;
+	}
+	remove("testcase29.ckpt");
+	delete reference;
+}